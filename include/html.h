@@ -19,9 +19,46 @@
 #ifndef HTML_H
 #define HTML_H
 
+#include <signal.h>
+
 #define HTML_TAPE_SIZE 30000
-/* 1: EOF leaves cell unchanged; 0: EOF == 0; 1: EOF ==  1 */
+/* The number of cells a growable tape reserves by default */
+#define HTML_TAPE_RESERVE (1 << 29)
+/* The number of cells a growable tape commits at once */
+#define HTML_TAPE_COMMIT_SIZE 65536
+/* The number of cells the part of a tape that programs touched grows by at once */
+#define HTML_TAPE_TOUCH_SIZE 4096
+/* The number of cells of the guard regions before and after a guarded tape */
+#define HTML_TAPE_GUARD_SIZE (1 << 24)
+/* The number of cells a sparse tape allocates at once, as a power of two */
+#define HTML_TAPE_PAGE_SHIFT 12
+#define HTML_TAPE_PAGE_SIZE (1 << HTML_TAPE_PAGE_SHIFT)
+/* The default of eof_behavior: 1: EOF leaves cell unchanged; 0: EOF == 0; -1: EOF == -1 */
 #define HTML_EOF_BEHAVIOR 1
+#define HTML_EOF_UNCHANGED 1
+#define HTML_EOF_ZERO 0
+#define HTML_EOF_MINUS_ONE -1
+/* The fuel of a context that runs programs without a limit */
+#define HTML_FUEL_UNLIMITED -1
+/* The number of loop iterations a program runs between looks at its fuel and at stop requests */
+#define HTML_FUEL_SLICE 65536
+/* Why an execution ended: the program ran to its end, was stopped, ran out of fuel, moved
+ * 	off either end of the tape, could not write its output or could not allocate memory */
+#define HTML_EXECUTION_DONE 0
+#define HTML_EXECUTION_STOPPED 1
+#define HTML_EXECUTION_OUT_OF_FUEL 2
+#define HTML_EXECUTION_OVERRUN 3
+#define HTML_EXECUTION_UNDERRUN 4
+#define HTML_EXECUTION_IO_ERROR 5
+#define HTML_EXECUTION_OUT_OF_MEMORY 6
+/* The position of an execution status when the operation is not known */
+#define HTML_POSITION_UNKNOWN ((size_t)-1)
+/* The number of output bytes an execution context buffers before it flushes them */
+#define HTML_OUTPUT_BUFFER_SIZE 65536
+/* The number of input bytes an execution context reads from a file descriptor at once */
+#define HTML_INPUT_BUFFER_SIZE 65536
+/* The largest number of instructions the first block of a parsed program holds */
+#define HTML_ARENA_SIZE 65536
 
 #define HTML_TOKEN_PLUS 't'
 #define HTML_TOKEN_MINUS 'm'
@@ -37,8 +74,71 @@
 #define HTML_TOKEN_BREAK -10
 #endif
 
+/* Sets the current cell to the difference, created by html_optimize */
+#define HTML_INSTRUCTION_SET -2
+/* Adds the current cell times the difference to the cell at the offset, created by html_optimize */
+#define HTML_INSTRUCTION_MULTIPLY -3
+/* Moves the pointer by the difference until the current cell is zero, created by html_optimize */
+#define HTML_INSTRUCTION_SCAN -4
+/* A loop that ends every iteration on the cell it started at and keeps the pointer between
+ * the offset and the difference, created by html_optimize */
+#define HTML_INSTRUCTION_BALANCED_LOOP -5
+
+#define HTML_OP_END 0
+#define HTML_OP_ADD 1
+#define HTML_OP_MOVE 2
+#define HTML_OP_OUTPUT 3
+#define HTML_OP_INPUT 4
+#define HTML_OP_LOOP_START 5
+#define HTML_OP_LOOP_END 6
+#define HTML_OP_BREAK 7
+#define HTML_OP_SET 8
+#define HTML_OP_MULTIPLY 9
+#define HTML_OP_SCAN 10
+#define HTML_OP_CHECK 11
+
+/* The program was parsed successfully */
+#define HTML_PARSE_OK 0
+/* A loop is started but never ended */
+#define HTML_PARSE_UNMATCHED_LOOP_START 1
+/* A loop is ended that was never started */
+#define HTML_PARSE_UNMATCHED_LOOP_END 2
+/* Memory for the instructions could not be allocated */
+#define HTML_PARSE_OUT_OF_MEMORY 3
+
+/* Executes compiled programs with a single switch statement */
+#define HTML_ENGINE_SWITCH 0
+/* Executes compiled programs with threaded dispatch when the compiler supports it */
+#define HTML_ENGINE_THREADED 1
+/* Executes compiled programs as x86-64 machine code when built with the JIT */
+#define HTML_ENGINE_JIT 2
+
+/* The tape is allocated in full when the context is created */
+#define HTML_TAPE_FIXED 0
+/* The tape reserves its size in virtual memory and commits it as the pointer advances */
+#define HTML_TAPE_GROWABLE 1
+/* A growable tape between guard regions, so compiled programs run without bounds checks */
+#define HTML_TAPE_GUARDED 2
+/* A growable tape that also grows to the left of cell 0, into negative indexes */
+#define HTML_TAPE_BIDIRECTIONAL 4
+/* The tape allocates pages of cells on first access, for huge tapes that are mostly unused */
+#define HTML_TAPE_SPARSE 8
+/* The cells of the tape have 16 or 32 bits instead of 8 */
+#define HTML_TAPE_CELLS_16 16
+#define HTML_TAPE_CELLS_32 32
+
 #define READLINE_HIST_SIZE 20
 
+/**
+ * The blocks the instructions of a parsed program are allocated from.
+ */
+struct HtmlArena;
+
+/**
+ * The pages of a sparse tape.
+ */
+struct HtmlPageTable;
+
 /**
  * Represents a html instruction.
  */
@@ -66,6 +166,16 @@ typedef struct HtmlInstruction
 	 * 	<code>NULL</code>
 	 */
     struct HtmlInstruction *loop;
+    /**
+	 * The position of the cell this instruction operates on, relative to the
+	 * 	current cell. Only used by instructions created by html_optimize.
+	 */
+    int offset;
+    /**
+	 * The arena the instruction is allocated from, or <code>NULL</code> if it
+	 * 	is allocated on its own.
+	 */
+    struct HtmlArena *arena;
 } HtmlInstruction;
 
 /**
@@ -84,6 +194,97 @@ typedef struct HtmlState
     struct HtmlInstruction *head;
 } HtmlState;
 
+/**
+ * Describes why a program could not be parsed.
+ */
+typedef struct HtmlParseError
+{
+    /**
+	 * The reason of the failure, one of the <code>HTML_PARSE_*</code> values.
+	 */
+    int type;
+    /**
+	 * The byte offset of the unmatched loop token in the parsed source.
+	 */
+    size_t offset;
+} HtmlParseError;
+
+/**
+ * Represents a single operation of a compiled html program.
+ */
+typedef struct HtmlOp
+{
+    /**
+	 * The amount this operation applies: the value added to or stored in the
+	 * 	cell, the number of cells the pointer moves (negative to the left), the
+	 * 	number of bytes read or written or, for <code>HTML_OP_CHECK</code>, the
+	 * 	highest offset accessed by the following operations.
+	 */
+    int difference;
+    /**
+	 * The index of the matching loop operation if this is a loop operation.
+	 * 	Otherwise <code>0</code>.
+	 */
+    int jump;
+    /**
+	 * The position of the cell this operation operates on, relative to the
+	 * 	current cell or, for <code>HTML_OP_CHECK</code>, the lowest offset
+	 * 	accessed by the following operations.
+	 */
+    int offset;
+    /**
+	 * The type of this operation, one of the <code>HTML_OP_*</code> values.
+	 */
+    unsigned char type;
+} HtmlOp;
+
+/**
+ * A html program compiled into a contiguous array of operations, with the
+ * 	jump targets of all loops resolved. A program does not depend on the
+ * 	instructions it was compiled from and can be executed any number of times.
+ * 	Executions never change it, so any number of threads can execute it at
+ * 	once, each in a context of its own.
+ */
+typedef struct HtmlProgram
+{
+    /**
+	 * The operations of the program, terminated by a <code>HTML_OP_END</code>
+	 * 	operation.
+	 */
+    struct HtmlOp *ops;
+    /**
+	 * The number of operations in <code>ops</code>, including the terminating
+	 * 	<code>HTML_OP_END</code> operation.
+	 */
+    size_t length;
+    /**
+	 * The machine code generated for this program by the JIT, or
+	 * 	<code>NULL</code> if it could not be generated or the library was
+	 * 	built without the JIT. <code>html_compile</code> generates it.
+	 */
+    void *code;
+    /**
+	 * The size of the mapping that holds <code>code</code>.
+	 */
+    size_t code_size;
+    /**
+	 * The offsets of the machine code of the operations in <code>code</code>,
+	 * 	where a stopped program resumes.
+	 */
+    size_t *code_offsets;
+    /**
+	 * The largest number of cells an operation moves the pointer or reaches
+	 * 	away from the current cell.
+	 */
+    long reach;
+    /**
+	 * A number no other program compiled by this process has, which tells
+	 * 	the program a stopped execution resumes apart from a later one that
+	 * 	got the same address.
+	 */
+    unsigned long serial;
+} HtmlProgram;
+
 /**
  * The callback that will be invoked when the HTML_TOKEN_OUTPUT token is found.
  * 
@@ -98,12 +299,72 @@ typedef int (*HtmlOutputHandler)(int chr);
  */
 typedef char (*HtmlInputHandler)(void);
 
+struct HtmlExecutionContext;
+
+/**
+ * How and where an execution ended.
+ */
+typedef struct HtmlStatus
+{
+    /**
+	 * One of the <code>HTML_EXECUTION_*</code> values.
+	 */
+    int code;
+    /**
+	 * The index of the operation of a compiled program the execution ended
+	 * 	at, or <code>HTML_POSITION_UNKNOWN</code> if the tree interpreter ran
+	 * 	the instructions itself or the guard regions of a guarded tape caught
+	 * 	the fault.
+	 */
+    size_t position;
+    /**
+	 * The instruction the tree interpreter ended at, or <code>NULL</code>
+	 * 	for compiled programs and programs that ran to their end.
+	 */
+    const struct HtmlInstruction *instruction;
+    /**
+	 * The index of the current cell when the execution ended, or of the cell
+	 * 	that was accessed for faults caught by the guard regions and for pages
+	 * 	of a sparse tape that could not be allocated.
+	 */
+    long tape_index;
+} HtmlStatus;
+
+/**
+ * The callback that receives the buffered output of a program in bulk.
+ *
+ * @param context The context of the execution that produced the output.
+ * @param buffer The bytes that were output.
+ * @param length The number of bytes in <code>buffer</code>.
+ * @return 0 on success, a negative value if the output could not be written.
+ */
+typedef int (*HtmlOutputSink)(struct HtmlExecutionContext *context, const char *buffer,
+                              size_t length);
+
+/**
+ * The callback that reads the input of a program in blocks.
+ *
+ * @param context The context of the execution that reads the input.
+ * @param buffer The buffer to store the bytes in.
+ * @param capacity The number of bytes <code>buffer</code> can hold.
+ * @return The number of bytes read, 0 at the end of the input. Negative
+ * 	values end the input as well.
+ */
+typedef long (*HtmlInputSource)(struct HtmlExecutionContext *context, char *buffer, size_t capacity);
+
 /**
  * This structure is used as a layer between a html program and
  * 	the outside. It allows control over input, output and memory.
+ * 	Every thread that executes programs needs a context of its own, the
+ * 	programs themselves can be shared.
  */
 typedef struct HtmlExecutionContext
 {
+    /**
+	 * Data of the caller, which its sinks and sources can reach through the
+	 * 	context. The library does not use it.
+	 */
+    void *userdata;
     /**
 	 * The callback that will be invoked when the HTML_TOKEN_OUTPUT token is found.
 	 */
@@ -117,17 +378,154 @@ typedef struct HtmlExecutionContext
 	 */
     unsigned char *tape;
     /**
-	 * Index into <code>tape</code>. Modified during execution.
+	 * Index into <code>tape</code>. Modified during execution. Negative on
+	 * 	bidirectional tapes when the pointer is left of cell 0.
 	 */
     int tape_index;
     /**
-	 * size of the tape in number of cells.
+	 * The number of cells from cell 0 on that programs may have touched since
+	 * 	the context was created or reset, which is the high-water mark of the
+	 * 	tape. The engines check the pointer against it and grow it in steps
+	 * 	of <code>HTML_TAPE_TOUCH_SIZE</code> cells, guarded tapes in steps of
+	 * 	<code>HTML_TAPE_COMMIT_SIZE</code> cells. Equal to
+	 * 	<code>tape_limit</code> for sparse tapes.
 	 */
     size_t tape_size;
     /**
-	 * A flag that, if set to true, indicates that execution should stop.
+	 * The number of cells before <code>tape</code> that programs may have
+	 * 	touched, which are indexed with negative indexes. Always 0 unless the
+	 * 	tape is bidirectional.
+	 */
+    size_t tape_low;
+    /**
+	 * The number of cells the tape can grow to. Bidirectional tapes can grow
+	 * 	this far on either side of cell 0.
+	 */
+    size_t tape_limit;
+    /**
+	 * The number of cells from cell 0 on and before it that are backed by
+	 * 	memory, which <code>tape_size</code> and <code>tape_low</code> grow
+	 * 	into. Growable tapes commit more of their cells when they reach them.
+	 */
+    size_t tape_committed;
+    size_t tape_committed_low;
+    /**
+	 * The kind of tape, a combination of the <code>HTML_TAPE_*</code> values.
+	 */
+    int tape_options;
+    /**
+	 * The pages of a sparse tape, <code>NULL</code> for other tapes, which
+	 * 	have their cells in <code>tape</code>.
+	 */
+    struct HtmlPageTable *tape_pages;
+    /**
+	 * The size of a cell in bytes: 1, 2 or 4. The engines are specialized
+	 * 	for each size, and the tree interpreter and the JIT leave the wider
+	 * 	cells to them.
+	 */
+    int cell_size;
+    /**
+	 * What an input at the end of the input stores in the cell, one of the
+	 * 	<code>HTML_EOF_*</code> values.
+	 */
+    int eof_behavior;
+    /**
+	 * The number of the sparse tape page accessed last, and its cells.
+	 */
+    long tape_page;
+    unsigned char *tape_page_cells;
+    /**
+	 * A flag that, if set to true, indicates that execution should stop. The
+	 * 	engines look at it together with the fuel, so a program stops within
+	 * 	<code>HTML_FUEL_SLICE</code> loop iterations. It stays set until it is
+	 * 	cleared, which lets a stopped compiled program resume. A signal
+	 * 	handler or another thread may set it while the program runs.
+	 */
+    volatile sig_atomic_t shouldStop;
+    /**
+	 * The number of loop iterations the programs may still run, or
+	 * 	<code>HTML_FUEL_UNLIMITED</code>. Only the back edges of loops use up
+	 * 	fuel, everything else runs at most once per iteration.
+	 */
+    long fuel;
+    /**
+	 * The part of the fuel the running engine has taken, which it charges
+	 * 	when it takes the next part or ends.
+	 */
+    long fuel_slice;
+    /**
+	 * The compiled program that was stopped or ran out of fuel, and the
+	 * 	operation it continues at the next time it is executed, or
+	 * 	<code>NULL</code> if the last program ran to its end, with the
+	 * 	serial number of the program.
+	 */
+    const struct HtmlProgram *resume_program;
+    size_t resume_position;
+    unsigned long resume_serial;
+    /**
+	 * How and where the running or last execution ended.
+	 */
+    HtmlStatus status;
+    /**
+	 * Where an error unwinds the running execution to, private to the
+	 * 	library.
+	 */
+    void *unwind;
+    /**
+	 * The engine used to execute compiled programs, either
+	 * 	<code>HTML_ENGINE_SWITCH</code>, <code>HTML_ENGINE_THREADED</code> or
+	 * 	<code>HTML_ENGINE_JIT</code>. The threaded engine falls back to the
+	 * 	switch engine on compilers without support for label addresses, the JIT
+	 * 	falls back to the threaded engine when the library was built without it
+	 * 	or for another architecture than x86-64.
+	 */
+    int engine;
+    /**
+	 * The callback that receives buffered output in bulk, or <code>NULL</code>
+	 * 	to pass every buffered byte to <code>output_handler</code>. Output is
+	 * 	flushed when the buffer is full, before input is read, before errors
+	 * 	are reported and when execution ends or stops.
+	 */
+    HtmlOutputSink output_sink;
+    /**
+	 * The callback input is read from in blocks, or <code>NULL</code>.
+	 */
+    HtmlInputSource input_source;
+    /**
+	 * The output that has not been flushed yet.
+	 */
+    char *output_buffer;
+    /**
+	 * The number of bytes in <code>output_buffer</code>.
+	 */
+    size_t output_length;
+    /**
+	 * The number of bytes <code>output_buffer</code> can hold.
+	 */
+    size_t output_capacity;
+    /**
+	 * The file descriptor input is read from in blocks, or -1.
+	 */
+    int input_fd;
+    /**
+	 * The bytes of input that have been read but not consumed, or
+	 * 	<code>NULL</code> to read every byte with <code>input_handler</code>.
+	 * 	Points into <code>input_buffer</code> when reading from
+	 * 	<code>input_fd</code>, otherwise into the buffer of the caller.
+	 */
+    const char *input_data;
+    /**
+	 * The index of the next byte to consume in <code>input_data</code>.
+	 */
+    size_t input_position;
+    /**
+	 * The number of bytes in <code>input_data</code>.
 	 */
-    int shouldStop;
+    size_t input_length;
+    /**
+	 * The buffer blocks read from <code>input_fd</code> are stored in.
+	 */
+    char *input_buffer;
 } HtmlExecutionContext;
 
 /**
@@ -142,6 +540,86 @@ HtmlState *html_state();
  */
 HtmlExecutionContext *html_context(int);
 
+/**
+ * Creates a new context with the given kind of tape. A growable tape reserves
+ * 	<code>size</code> cells of virtual memory and commits them in steps of
+ * 	<code>HTML_TAPE_COMMIT_SIZE</code> cells when the program moves past the
+ * 	committed part. A guarded tape is also surrounded by regions that fault on
+ * 	access, which lets compiled programs run without checking the tape bounds,
+ * 	and rounds its size up to a multiple of <code>HTML_TAPE_COMMIT_SIZE</code>.
+ * 	A bidirectional tape reserves <code>size</code> cells on both sides of cell
+ * 	0 and commits the left side as the program moves below it, so the
+ * 	checks stay a comparison against the committed bounds. Without
+ * 	<code>mmap</code>, every tape except a sparse one is fixed.
+ *
+ * A sparse tape allocates a page of <code>HTML_TAPE_PAGE_SIZE</code> cells the
+ * 	first time a cell of it is accessed and keeps the last page at hand, so
+ * 	only the regions a program touches take memory. Its programs run on the
+ * 	switch or threaded engine, whichever engine the context selects.
+ *
+ * <code>HTML_TAPE_CELLS_16</code> and <code>HTML_TAPE_CELLS_32</code> widen
+ * 	the cells of any kind of tape, all sizes stay in number of cells.
+ *
+ * @param size The size or the limit of the tape in number of cells.
+ * @param options A combination of the <code>HTML_TAPE_*</code> values.
+ * @return The new context or <code>NULL</code> if the tape could not be allocated.
+ */
+HtmlExecutionContext *html_context_tape(size_t, int);
+
+/**
+ * Clears the cells of the given context that programs may have touched and
+ * 	moves the pointer back to cell 0, so the context can run the next program
+ * 	as if it was new. Only the cells between <code>tape_low</code> and
+ * 	<code>tape_size</code> are cleared, which cover the cells touched since
+ * 	the last reset in steps of <code>HTML_TAPE_TOUCH_SIZE</code> cells, or
+ * 	of <code>HTML_TAPE_COMMIT_SIZE</code> cells on guarded tapes, which give
+ * 	back all but their first step. Sparse tapes clear the pages accessed
+ * 	since the last reset and keep them for the next programs.
+ *
+ * @param context The context to reset.
+ */
+void html_context_reset(struct HtmlExecutionContext *);
+
+/**
+ * Passes the buffered output of the given context to its output sink, or to
+ * 	its output handler if it has no sink.
+ *
+ * @param context The context to flush the output of.
+ * @return 0 on success, -1 if the output sink failed.
+ */
+int html_output_flush(struct HtmlExecutionContext *);
+
+/**
+ * Makes the given context read its input in blocks from the given file
+ * 	descriptor instead of calling its input handler for every byte.
+ *
+ * @param context The context to read the input of.
+ * @param fd The file descriptor to read from.
+ * @return 0 on success, -1 if the buffer could not be allocated.
+ */
+int html_set_input_fd(struct HtmlExecutionContext *, int);
+
+/**
+ * Makes the given context read its input in blocks from the given callback
+ * 	instead of calling its input handler for every byte.
+ *
+ * @param context The context to read the input of.
+ * @param source The callback that reads the input.
+ * @return 0 on success, -1 if the buffer could not be allocated.
+ */
+int html_set_input_source(struct HtmlExecutionContext *, HtmlInputSource);
+
+/**
+ * Makes the given context read its input from the given memory buffer
+ * 	instead of calling its input handler for every byte. The buffer is not
+ * 	copied and must stay valid while the context reads from it.
+ *
+ * @param context The context to read the input of.
+ * @param data The input.
+ * @param length The number of bytes of input.
+ */
+void html_set_input_buffer(struct HtmlExecutionContext *, const char *, size_t);
+
 /**
  * Removes the given instruction from the linked list.
  * 
@@ -200,13 +678,37 @@ HtmlInstruction *html_insert_after(struct HtmlState *, struct HtmlInstruction *,
  */
 HtmlInstruction *html_parse_stream(FILE *);
 
+/**
+ * Reads the whole source behind the given file descriptor and parses it at once.
+ * 	Regular files are mapped into memory, other files such as pipes are read
+ * 	in large blocks.
+ *
+ * @param fd The file descriptor to read from.
+ * @return The head of the linked list containing the instructions or
+ * 	<code>NULL</code> if the source could not be parsed.
+ */
+HtmlInstruction *html_parse_fd(int);
+
+/**
+ * Reads the whole source behind the given file descriptor and parses it at
+ * 	once with the given number of threads, see
+ * 	<code>html_parse_buffer_parallel</code>.
+ *
+ * @param fd The file descriptor to read from.
+ * @param threads The number of threads to parse the source with.
+ * @return The head of the linked list containing the instructions or
+ * 	<code>NULL</code> if the source could not be parsed.
+ */
+HtmlInstruction *html_parse_fd_parallel(int, int);
+
 /**
  * Reads a character, converts it to an instruction and repeats until the given character
  * 	occurs and will then return a linked list containing all instructions.
  *
  * @param stream The stream to read from.
  * @param until If this character is found in the stream, we will quit reading and return.
- * @param The head of the linked list containing the instructions.
+ * @return The head of the linked list containing the instructions or <code>NULL</code>
+ * 	if the program is malformed, in which case the error is reported on stderr.
  */
 HtmlInstruction *html_parse_stream_until(FILE *, int);
 
@@ -242,10 +744,39 @@ HtmlInstruction *html_parse_substring(char *, int, int);
  *	Since this will be used as counter, the value of the pointer will be increased.
  * @param end The index you want to stop parsing at.
  *	When <code>-1</code> is given, it will stop at the end of the string.
- * @param The head of the linked list containing the instructions.
+ * @return The head of the linked list containing the instructions or <code>NULL</code>
+ * 	if the program is malformed, in which case the error is reported on stderr.
  */
 HtmlInstruction *html_parse_substring_incremental(char *, int *, int);
 
+/**
+ * Converts the given buffer into a linked list containing all instructions. Loops
+ * 	are matched with an explicit stack, so the nesting depth is only limited by
+ * 	the available memory.
+ *
+ * @param buffer The buffer to read from.
+ * @param length The number of bytes in the buffer.
+ * @param error The location to store the reason of a failure at, may be <code>NULL</code>.
+ * @return The head of the linked list containing the instructions or <code>NULL</code>
+ * 	if the program is malformed or memory ran out.
+ */
+HtmlInstruction *html_parse_buffer(const char *, size_t, HtmlParseError *);
+
+/**
+ * Converts the given buffer into a linked list containing all instructions,
+ * 	reading it with the given number of threads. The result is the same as
+ * 	the one of <code>html_parse_buffer</code>. Without thread support, the
+ * 	chunks of the buffer are read one after another.
+ *
+ * @param buffer The buffer to read from.
+ * @param length The number of bytes in the buffer.
+ * @param threads The number of threads to read the buffer with.
+ * @param error The location to store the reason of a failure at, may be <code>NULL</code>.
+ * @return The head of the linked list containing the instructions or <code>NULL</code>
+ * 	if the program is malformed or memory ran out.
+ */
+HtmlInstruction *html_parse_buffer_parallel(const char *, size_t, int, HtmlParseError *);
+
 /**
  * Converts the given character to an instruction.
  *
@@ -255,14 +786,39 @@ HtmlInstruction *html_parse_substring_incremental(char *, int *, int);
 HtmlInstruction *html_parse_character(char);
 
 /**
- * Destroys the given instruction.
+ * Optimizes the given linked list containing instructions in place: loops that
+ * 	clear the current cell, like <code>hml</code>, and loops that add multiples of
+ * 	the current cell to nearby cells, like <code>hmLtttLttHHl</code>, are replaced
+ * 	by straight-line <code>HTML_INSTRUCTION_MULTIPLY</code> and
+ * 	<code>HTML_INSTRUCTION_SET</code> instructions. The additions that follow
+ * 	a clear are folded into it. Loops that move the pointer to the next zero
+ * 	cell, like <code>hLl</code>, become a single <code>HTML_INSTRUCTION_SCAN</code>.
+ * 	Loops that return to the cell they started at become a
+ * 	<code>HTML_INSTRUCTION_BALANCED_LOOP</code>, whose pointer range
+ * 	<code>html_execute</code> checks once when it enters the loop.
+ * 	The given instruction stays the start of the list. Loops whose bodies
+ * 	cannot be visited for lack of memory are left as they are.
+ *
+ * @param root The start of the linked list of instructions you want
+ * 	to optimize.
+ */
+void html_optimize(struct HtmlInstruction *);
+
+/**
+ * Destroys the given instruction. The parsers allocate the instructions of a
+ * 	program from an arena, which is only released with its last instruction.
  * 
  * @param instruction The instruction to destroy.
  */
 void html_destroy_instruction(struct HtmlInstruction *);
 
 /**
- * Destroys a linked list containing instructions.
+ * Destroys a linked list containing instructions. A program destroyed from
+ * 	the instruction a parser returned is released with its arena in one call,
+ * 	unless <code>html_add</code>, <code>html_remove</code> or the other list
+ * 	functions linked it to other instructions or unlinked some of its own.
+ * 	Instructions unlinked from such a program by hand must be destroyed
+ * 	before it.
  * 
  * @param head The start of the instruction list.
  */
@@ -283,14 +839,89 @@ void html_destroy_state(struct HtmlState *);
 void html_destroy_context(struct HtmlExecutionContext *);
 
 /**
- * Executes the given linked list containing instructions.
+ * Executes the given linked list containing instructions. Errors end the
+ * 	execution with their status, the process keeps running. A program that
+ * 	is stopped or runs out of fuel cannot be resumed, compiled programs can.
+ * 	On sparse tapes and tapes of wider cells the instructions are compiled
+ * 	and run as a program that is destroyed when it ends, so neither can
+ * 	those.
  *
  * @param root The start of the linked list of instructions you want
  * 	to execute.
  * @param context The context of this execution that contains the tape and
  *	other execution related variables.
+ * @return How and where the execution ended.
+ */
+HtmlStatus html_execute(struct HtmlInstruction *, struct HtmlExecutionContext *);
+
+/**
+ * Compiles the given linked list containing instructions into a program.
+ * 	Compilation stops at the same point <code>html_execute</code> would.
+ * 	When built with the JIT, the machine code is generated here as well.
+ *
+ * @param root The start of the linked list of instructions you want
+ * 	to compile.
+ * @return The compiled program or <code>NULL</code> if it could not be allocated.
+ */
+HtmlProgram *html_compile(struct HtmlInstruction *);
+
+/**
+ * Executes the given compiled program with the engine selected in the context.
+ * 	Errors end the execution with their status. A program that was stopped
+ * 	or ran out of fuel in this context continues where it left off, once the
+ * 	stop request is cleared or fuel is added. Several threads may execute
+ * 	the same program at once, as long as they use different contexts.
+ *
+ * @param program The program to execute.
+ * @param context The context of this execution that contains the tape and
+ *	other execution related variables.
+ * @return How and where the execution ended.
+ */
+HtmlStatus html_execute_program(const struct HtmlProgram *, struct HtmlExecutionContext *);
+
+/**
+ * Executes the given compiled program in the given context from a cleared
+ * 	tape, reading its input from a buffer and writing its output into
+ * 	another one, without stdio or callbacks. The tape is cleared with
+ * 	<code>html_context_reset</code> first, which only clears the range of
+ * 	cells the programs before touched. Output beyond
+ * 	<code>output_capacity</code> ends the execution with
+ * 	<code>HTML_EXECUTION_IO_ERROR</code>. The context keeps its own input
+ * 	and output settings for later executions.
+ *
+ * @param program The program to execute.
+ * @param context The context of this execution.
+ * @param input The input of the program, or <code>NULL</code> for none.
+ * @param input_length The number of bytes of input, ignored without input.
+ * @param output The buffer the output is written into.
+ * @param output_capacity The number of bytes <code>output</code> can hold.
+ * @param status Where to store how and where the execution ended, or
+ * 	<code>NULL</code>.
+ * @return The number of bytes written into <code>output</code>.
+ */
+size_t html_run_buffer(const struct HtmlProgram *, struct HtmlExecutionContext *, const char *, size_t, char *,
+                       size_t, HtmlStatus *);
+
+/**
+ * Destroys a compiled program.
+ *
+ * @param program The program to destroy.
+ */
+void html_destroy_program(struct HtmlProgram *);
+
+/**
+ * Writes a standalone C program that behaves like the given compiled program
+ * 	executed in the given context, with a tape of as many cells as the
+ * 	context can grow to, on either side of cell 0 if it is bidirectional,
+ * 	and its end of input behavior.
+ *
+ * @param program The program to translate.
+ * @param context The context whose tape and input settings the emitted
+ * 	program takes.
+ * @param stream The stream to write the C source code to.
+ * @return 0 on success, -1 if the stream reported an error.
  */
-void html_execute(struct HtmlInstruction *, struct HtmlExecutionContext *);
+int html_emit_c(const struct HtmlProgram *, const struct HtmlExecutionContext *, FILE *);
 
 /**
  * Stops the currently running program referenced by the given execution context.
@@ -301,7 +932,8 @@ void html_execute(struct HtmlInstruction *, struct HtmlExecutionContext *);
 void html_execution_stop(HtmlExecutionContext *);
 
 /**
- * Reads exactly one char from stdin.
+ * Reads exactly one char from stdin and discards the rest of the line, for
+ * 	interactive use.
  * @return The character read from stdin. 
  */
 char html_getchar(void);
@@ -17,14 +17,76 @@
  * limitations under the License.
  */
 
+/* For memrchr */
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <assert.h>
+#include <errno.h>
+#include <setjmp.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#define read _read
+#else
+#include <unistd.h>
+#endif
 
 #include <html.h>
 
+/* Label addresses (computed goto) are supported by GCC and Clang */
+#if defined(__GNUC__)
+#define HTML_HAVE_THREADED_ENGINE
+#endif
+
+/* SSE2 and AVX2 kernels, selected at runtime by the CPU features */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HTML_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* Source files are mapped into memory where mmap is available */
+#if !defined(_WIN32)
+#define HTML_HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* Guarded tapes catch accesses outside of them with a SIGSEGV handler that knows
+ * 	the tape of the running thread */
+#if defined(HTML_HAVE_MMAP) && defined(__GNUC__)
+#define HTML_HAVE_GUARD
+#include <signal.h>
+#endif
+
+/* Errors unwind the running execution to html_execute or html_execute_program, from the
+ * 	SIGSEGV handler of guarded tapes too, which does not block the signal it handles */
+#ifdef HTML_HAVE_GUARD
+typedef sigjmp_buf HtmlUnwind;
+#define HTML_UNWIND_SET(unwind) sigsetjmp(unwind, 0)
+#define HTML_UNWIND(unwind) siglongjmp(unwind, 1)
+#else
+typedef jmp_buf HtmlUnwind;
+#define HTML_UNWIND_SET(unwind) setjmp(unwind)
+#define HTML_UNWIND(unwind) longjmp(unwind, 1)
+#endif
+
+/* Parallel parsing runs on POSIX threads when they are available, which also need the
+ * 	few globals of the executions locked */
+#ifdef HTML_PTHREADS
+#define HTML_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+/* The JIT emits System V x86-64 code into pages mapped with mmap */
+#if defined(HTML_JIT) && defined(__x86_64__) && defined(HTML_HAVE_MMAP)
+#define HTML_HAVE_JIT
+#include <stddef.h>
+#endif
+
 /**
  * Creates a new state.
  */
@@ -36,6 +98,220 @@ HtmlState *html_state()
     return state;
 }
 
+/**
+ * Reads one char from stdin, the default input handler.
+ *
+ * @return The character read from stdin.
+ */
+static char html_getchar_stdin(void)
+{
+    return (char)getchar();
+}
+
+static void html_arena_mix(HtmlInstruction *instruction, HtmlInstruction *other);
+#ifdef HTML_HAVE_JIT
+static int html_jit_compile(HtmlProgram *program);
+#endif
+
+/**
+ * The pages of a sparse tape, in a hash table with open addressing that is
+ * 	indexed by the page numbers. The table holds the pages accessed since it
+ * 	was last emptied, the pages before are kept cleared for later ones.
+ */
+struct HtmlPageTable
+{
+    /**
+	 * The page numbers of the slots, the cells of a slot are NULL while it is empty.
+	 */
+    long *numbers;
+    unsigned char **cells;
+    /**
+	 * The number of slots, a power of two, and the number of pages.
+	 */
+    size_t capacity;
+    size_t count;
+    /**
+	 * The cleared pages that are not in the table, their number and the
+	 * 	number of pages <code>spare</code> can hold.
+	 */
+    unsigned char **spare;
+    size_t spare_count;
+    size_t spare_capacity;
+};
+
+/**
+ * Creates an empty page table for a sparse tape.
+ *
+ * @return The page table or <code>NULL</code> if it could not be allocated.
+ */
+static struct HtmlPageTable *html_page_table(void)
+{
+    struct HtmlPageTable *table = (struct HtmlPageTable *)malloc(sizeof(struct HtmlPageTable));
+    if (table == NULL)
+        return NULL;
+    table->capacity = 64;
+    table->count = 0;
+    table->spare = 0;
+    table->spare_count = 0;
+    table->spare_capacity = 0;
+    table->numbers = (long *)malloc(table->capacity * sizeof(long));
+    table->cells = (unsigned char **)calloc(table->capacity, sizeof(unsigned char *));
+    if (table->numbers == NULL || table->cells == NULL)
+    {
+        free(table->numbers);
+        free(table->cells);
+        free(table);
+        return NULL;
+    }
+    return table;
+}
+
+/**
+ * Destroys the given page table and the pages in it.
+ *
+ * @param table The page table to destroy, may be <code>NULL</code>.
+ */
+static void html_destroy_page_table(struct HtmlPageTable *table)
+{
+    size_t i;
+    if (table == NULL)
+        return;
+    for (i = 0; i < table->capacity; i++)
+        free(table->cells[i]);
+    for (i = 0; i < table->spare_count; i++)
+        free(table->spare[i]);
+    free(table->numbers);
+    free(table->cells);
+    free(table->spare);
+    free(table);
+}
+
+/**
+ * Clears the pages of the given page table and empties it, keeping the pages
+ * 	for the ones it adds next. Pages that do not fit in the list of spare
+ * 	pages are freed.
+ *
+ * @param table The page table to empty.
+ * @param width The size of a cell in bytes.
+ */
+static void html_page_release(struct HtmlPageTable *table, int width)
+{
+    size_t i;
+    if (table->count == 0)
+        return;
+    if (table->spare_count + table->count > table->spare_capacity)
+    {
+        size_t capacity = table->spare_count + table->count;
+        unsigned char **spare = (unsigned char **)realloc(table->spare, capacity * sizeof(unsigned char *));
+        if (spare != NULL)
+        {
+            table->spare = spare;
+            table->spare_capacity = capacity;
+        }
+    }
+    for (i = 0; i < table->capacity; i++)
+    {
+        if (table->cells[i] == NULL)
+            continue;
+        if (table->spare_count < table->spare_capacity)
+        {
+            memset(table->cells[i], 0, (size_t)HTML_TAPE_PAGE_SIZE * width);
+            table->spare[table->spare_count++] = table->cells[i];
+        }
+        else
+            free(table->cells[i]);
+        table->cells[i] = NULL;
+    }
+    table->count = 0;
+}
+
+/**
+ * Computes the slot a page number starts its probe sequence at.
+ *
+ * @param table The page table.
+ * @param number The page number.
+ * @return The index of the slot.
+ */
+static size_t html_page_slot(const struct HtmlPageTable *table, long number)
+{
+    /* Fibonacci hashing spreads consecutive page numbers over the table */
+    return (size_t)(((unsigned long)number * 0x9E3779B1UL) >> 7) & (table->capacity - 1);
+}
+
+/**
+ * Looks up the given page of a sparse tape.
+ *
+ * @param table The page table.
+ * @param number The page number.
+ * @return The cells of the page or <code>NULL</code> if it was never accessed.
+ */
+static unsigned char *html_page_find(const struct HtmlPageTable *table, long number)
+{
+    size_t slot = html_page_slot(table, number);
+    while (table->cells[slot] != NULL)
+    {
+        if (table->numbers[slot] == number)
+            return table->cells[slot];
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    return NULL;
+}
+
+/**
+ * Adds a zeroed page to a sparse tape, a spare one if there is any, doubling
+ * 	the table when it is half full.
+ *
+ * @param table The page table.
+ * @param number The number of the page, which must not be in the table yet.
+ * @param width The size of a cell in bytes.
+ * @return The cells of the page or <code>NULL</code> if they could not be allocated.
+ */
+static unsigned char *html_page_add(struct HtmlPageTable *table, long number, int width)
+{
+    size_t slot;
+    unsigned char *cells;
+    if (2 * (table->count + 1) > table->capacity)
+    {
+        struct HtmlPageTable larger = *table;
+        size_t i;
+        larger.capacity = 2 * table->capacity;
+        larger.numbers = (long *)malloc(larger.capacity * sizeof(long));
+        larger.cells = (unsigned char **)calloc(larger.capacity, sizeof(unsigned char *));
+        if (larger.numbers == NULL || larger.cells == NULL)
+        {
+            free(larger.numbers);
+            free(larger.cells);
+            return NULL;
+        }
+        for (i = 0; i < table->capacity; i++)
+        {
+            if (table->cells[i] == NULL)
+                continue;
+            slot = html_page_slot(&larger, table->numbers[i]);
+            while (larger.cells[slot] != NULL)
+                slot = (slot + 1) & (larger.capacity - 1);
+            larger.numbers[slot] = table->numbers[i];
+            larger.cells[slot] = table->cells[i];
+        }
+        free(table->numbers);
+        free(table->cells);
+        *table = larger;
+    }
+    if (table->spare_count > 0)
+        cells = table->spare[--table->spare_count];
+    else
+        cells = (unsigned char *)calloc(HTML_TAPE_PAGE_SIZE, (size_t)width);
+    if (cells == NULL)
+        return NULL;
+    slot = html_page_slot(table, number);
+    while (table->cells[slot] != NULL)
+        slot = (slot + 1) & (table->capacity - 1);
+    table->numbers[slot] = number;
+    table->cells[slot] = cells;
+    table->count++;
+    return cells;
+}
+
 /**
  * Creates a new html context.
  *
@@ -45,18 +321,162 @@ HtmlExecutionContext *html_context(int size)
 {
     if (size < 0)
         size = HTML_TAPE_SIZE;
+    return html_context_tape((size_t)size, HTML_TAPE_FIXED);
+}
+
+#ifdef HTML_HAVE_MMAP
+/**
+ * Computes the number of bytes the mapping of a growable tape spans, which
+ * 	is a multiple of the page size.
+ *
+ * @param limit The number of cells the tape can grow to.
+ * @param options The kind of tape.
+ * @param width The size of a cell in bytes.
+ * @return The size of the mapping.
+ */
+static size_t html_tape_mapping(size_t limit, int options, int width)
+{
+    size_t guard = options & HTML_TAPE_GUARDED ? HTML_TAPE_GUARD_SIZE : 0;
+    size_t side = (limit + HTML_TAPE_COMMIT_SIZE - 1) / HTML_TAPE_COMMIT_SIZE * HTML_TAPE_COMMIT_SIZE;
+    return ((options & HTML_TAPE_BIDIRECTIONAL ? 2 * side : side) + 2 * guard) * (size_t)width;
+}
+
+/**
+ * Computes the number of bytes the mapping of a growable tape spans before
+ * 	its first cell, which a bidirectional tape places in the middle.
+ *
+ * @param limit The number of cells the tape can grow to.
+ * @param options The kind of tape.
+ * @param width The size of a cell in bytes.
+ * @return The offset of the first cell in the mapping.
+ */
+static size_t html_tape_start(size_t limit, int options, int width)
+{
+    size_t guard = options & HTML_TAPE_GUARDED ? HTML_TAPE_GUARD_SIZE : 0;
+    if (!(options & HTML_TAPE_BIDIRECTIONAL))
+        return guard * (size_t)width;
+    return ((limit + HTML_TAPE_COMMIT_SIZE - 1) / HTML_TAPE_COMMIT_SIZE * HTML_TAPE_COMMIT_SIZE + guard) *
+           (size_t)width;
+}
+#endif
+
+/**
+ * Computes the number of cells from cell 0 on a tape marks as touched before
+ * 	a program runs on it. Guarded tapes mark their whole first commit step,
+ * 	which the engines without bounds checks may touch.
+ *
+ * @param limit The number of cells the tape can grow to.
+ * @param options The kind of tape.
+ * @return The number of cells.
+ */
+static size_t html_tape_touched(size_t limit, int options)
+{
+    size_t step = options & HTML_TAPE_GUARDED ? HTML_TAPE_COMMIT_SIZE : HTML_TAPE_TOUCH_SIZE;
+    return limit < step ? limit : step;
+}
+
+/**
+ * Creates a new html context with the given kind of tape.
+ *
+ * @param size The size or the limit of the tape in number of cells.
+ * @param options A combination of the <code>HTML_TAPE_*</code> values.
+ * @return The new context or <code>NULL</code> if the tape could not be allocated.
+ */
+HtmlExecutionContext *html_context_tape(size_t size, int options)
+{
+    unsigned char *tape = 0;
+    struct HtmlPageTable *pages = 0;
+    size_t committed;
+    int width = options & HTML_TAPE_CELLS_32 ? 4 : options & HTML_TAPE_CELLS_16 ? 2 : 1;
 
-    unsigned char *tape = calloc(size, sizeof(char));
+    options &= ~(HTML_TAPE_CELLS_16 | HTML_TAPE_CELLS_32);
+    /* The tape index is an int */
+    if (size > INT_MAX / 2)
+        size = INT_MAX / 2;
+    committed = size;
+    if (options & HTML_TAPE_SPARSE)
+        options &= HTML_TAPE_SPARSE | HTML_TAPE_BIDIRECTIONAL;
+    else if (options & (HTML_TAPE_GUARDED | HTML_TAPE_BIDIRECTIONAL))
+        options |= HTML_TAPE_GROWABLE;
+    if (options & HTML_TAPE_SPARSE)
+    {
+        /* Every cell of a sparse tape is addressable, the pages appear on first access */
+        pages = html_page_table();
+        if (pages == NULL)
+            return NULL;
+    }
+    else
+#ifdef HTML_HAVE_MMAP
+    if (options & HTML_TAPE_GROWABLE)
+    {
+        unsigned char *memory;
+        /* The guard regions protect whole commit steps, so the limit lies on one */
+        if (options & HTML_TAPE_GUARDED)
+            size = (size + HTML_TAPE_COMMIT_SIZE - 1) / HTML_TAPE_COMMIT_SIZE * HTML_TAPE_COMMIT_SIZE;
+        /* Reserve the whole range without backing it, then commit the start */
+        memory = (unsigned char *)mmap(NULL, html_tape_mapping(size, options, width), PROT_NONE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        committed = size < HTML_TAPE_COMMIT_SIZE ? size : HTML_TAPE_COMMIT_SIZE;
+        if (memory == (unsigned char *)MAP_FAILED)
+            return NULL;
+        tape = memory + html_tape_start(size, options, width);
+        if (mprotect(tape, (size_t)HTML_TAPE_COMMIT_SIZE * width, PROT_READ | PROT_WRITE) != 0)
+        {
+            munmap(memory, html_tape_mapping(size, options, width));
+            return NULL;
+        }
+    }
+    else
+#endif
+    {
+        options = HTML_TAPE_FIXED;
+        tape = (unsigned char *)calloc(size, (size_t)width);
+        if (tape == NULL && size > 0)
+            return NULL;
+    }
 
     HtmlExecutionContext *context = (HtmlExecutionContext *)
         malloc(sizeof(HtmlExecutionContext));
 
     context->output_handler = &putchar;
-    context->input_handler = &html_getchar;
+    context->input_handler = &html_getchar_stdin;
     context->tape = tape;
     context->tape_index = 0;
-    context->tape_size = size;
+    /* Every cell of a sparse tape lies within its bounds, its pages tell which ones were touched */
+    context->tape_size = pages != NULL ? size : html_tape_touched(size, options);
+    context->tape_low = pages != NULL && (options & HTML_TAPE_BIDIRECTIONAL) ? size : 0;
+    context->tape_limit = size;
+    context->tape_committed = committed;
+    context->tape_committed_low = context->tape_low;
+    context->tape_options = options;
+    context->tape_pages = pages;
+    context->tape_page = LONG_MAX;
+    context->tape_page_cells = 0;
+    context->cell_size = width;
+    context->eof_behavior = HTML_EOF_BEHAVIOR;
     context->shouldStop = 0;
+    context->fuel = HTML_FUEL_UNLIMITED;
+    context->fuel_slice = 0;
+    context->resume_program = 0;
+    context->resume_position = 0;
+    context->resume_serial = 0;
+    context->userdata = 0;
+    context->status.code = HTML_EXECUTION_DONE;
+    context->status.position = HTML_POSITION_UNKNOWN;
+    context->status.instruction = 0;
+    context->status.tape_index = 0;
+    context->unwind = 0;
+    context->engine = HTML_ENGINE_THREADED;
+    context->output_sink = 0;
+    context->input_source = 0;
+    context->output_buffer = (char *)malloc(HTML_OUTPUT_BUFFER_SIZE);
+    context->output_length = 0;
+    context->output_capacity = context->output_buffer == NULL ? 0 : HTML_OUTPUT_BUFFER_SIZE;
+    context->input_fd = -1;
+    context->input_data = 0;
+    context->input_position = 0;
+    context->input_length = 0;
+    context->input_buffer = 0;
     return context;
 }
 
@@ -73,6 +493,7 @@ HtmlInstruction *html_remove(HtmlState *state, HtmlInstruction *instruction)
         return NULL;
     if (state->head == instruction)
         state->head = instruction->previous;
+    html_arena_mix(instruction, NULL);
     instruction->previous->next = instruction->next;
     instruction->next->previous = instruction->previous;
     instruction->previous = 0;
@@ -94,7 +515,10 @@ HtmlInstruction *html_add(HtmlState *state,
         return NULL;
     instruction->previous = state->head;
     if (state->head != NULL)
+    {
         state->head->next = instruction;
+        html_arena_mix(state->head, instruction);
+    }
     HtmlInstruction *iter = instruction;
     while (iter != NULL)
     {
@@ -135,6 +559,7 @@ HtmlInstruction *html_add_front(HtmlState *state,
     }
     iter->next = state->root;
     state->root->previous = iter;
+    html_arena_mix(iter, state->root);
     state->root = instruction;
     return state->head;
 }
@@ -162,6 +587,7 @@ HtmlInstruction *html_insert_before(HtmlState *state, HtmlInstruction *before,
     }
     before->previous = iter;
     iter->next = iter;
+    html_arena_mix(instruction, before);
 
     if (previous != NULL)
     {
@@ -191,6 +617,7 @@ HtmlInstruction *html_insert_after(HtmlState *state, HtmlInstruction *after,
 
     after->next = instruction;
     instruction->previous = after;
+    html_arena_mix(after, instruction);
     while (iter != NULL)
     {
         if (iter->next == NULL)
@@ -221,84 +648,172 @@ HtmlInstruction *html_parse_stream(FILE *stream)
     return html_parse_stream_until(stream, EOF);
 }
 
+/**
+ * Reports a parse error on stderr.
+ *
+ * @param error The error to report.
+ * @param base The offset of the parsed buffer in the source the user knows.
+ */
+static void html_print_parse_error(const HtmlParseError *error, size_t base)
+{
+    switch (error->type)
+    {
+    case HTML_PARSE_UNMATCHED_LOOP_START:
+        fprintf(stderr, "error: unmatched '%c' at byte %lu\n", HTML_TOKEN_LOOP_START,
+                (unsigned long)(base + error->offset));
+        break;
+    case HTML_PARSE_UNMATCHED_LOOP_END:
+        fprintf(stderr, "error: unmatched '%c' at byte %lu\n", HTML_TOKEN_LOOP_END,
+                (unsigned long)(base + error->offset));
+        break;
+    case HTML_PARSE_OUT_OF_MEMORY:
+        fprintf(stderr, "error: out of memory\n");
+        break;
+    }
+}
+
 /**
  * Reads a character, converts it to an instruction and repeats until the given character
  * 	occurs and will then return a linked list containing all instructions.
  *
  * @param stream The stream to read from.
  * @param until If this character is found in the stream, we will quit reading and return.
- * @param The head of the linked list containing the instructions.
+ * @return The head of the linked list containing the instructions or <code>NULL</code>
+ * 	if the program is malformed, in which case the error is reported on stderr.
  */
 HtmlInstruction *html_parse_stream_until(FILE *stream, const int until)
 {
-    HtmlInstruction *instruction = (HtmlInstruction *)malloc(sizeof(HtmlInstruction));
-    instruction->next = 0;
-    instruction->loop = 0;
-    HtmlInstruction *root = instruction;
-    char ch;
-    char temp;
-    while ((ch = fgetc(stream)) != until)
+    size_t length = 0, size = 4096;
+    char *buffer = (char *)malloc(size);
+    HtmlParseError error;
+    HtmlInstruction *root;
+    int ch;
+
+    while (buffer != NULL)
     {
-        if (ch == EOF || feof(stream))
-        {
-            break;
-        }
-        instruction->type = ch;
-        instruction->difference = 1;
-        switch (ch)
+        if (length == size)
         {
-        case HTML_TOKEN_PLUS:
-        case HTML_TOKEN_MINUS:
-            while ((temp = fgetc(stream)) != until && (temp == HTML_TOKEN_PLUS || temp == HTML_TOKEN_MINUS))
+            char *larger = (char *)realloc(buffer, size * 2);
+            if (larger == NULL)
             {
-                if (temp == ch)
-                {
-                    instruction->difference++;
-                }
-                else
-                {
-                    instruction->difference--;
-                }
+                free(buffer);
+                buffer = NULL;
+                break;
             }
-            ungetc(temp, stream);
-            break;
-        case HTML_TOKEN_NEXT:
-        case HTML_TOKEN_PREVIOUS:
-            while ((temp = fgetc(stream)) != until && (temp == HTML_TOKEN_NEXT || temp == HTML_TOKEN_PREVIOUS))
+            buffer = larger;
+            size *= 2;
+        }
+        if (until == EOF)
+        {
+            size_t count = fread(buffer + length, 1, size - length, stream);
+            length += count;
+            if (count == 0)
+                break;
+        }
+        else
+        {
+            if ((ch = fgetc(stream)) == EOF || ch == until)
+                break;
+            buffer[length++] = (char)ch;
+        }
+    }
+    if (buffer == NULL)
+    {
+        error.type = HTML_PARSE_OUT_OF_MEMORY;
+        html_print_parse_error(&error, 0);
+        return NULL;
+    }
+    root = html_parse_buffer(buffer, length, &error);
+    free(buffer);
+    if (root == NULL)
+        html_print_parse_error(&error, 0);
+    return root;
+}
+
+/**
+ * Reads the whole source behind the given file descriptor and parses it at once.
+ * 	Regular files are mapped into memory, other files such as pipes are read
+ * 	in large blocks.
+ *
+ * @param fd The file descriptor to read from.
+ * @return The head of the linked list containing the instructions or
+ * 	<code>NULL</code> if the source could not be parsed.
+ */
+HtmlInstruction *html_parse_fd(int fd)
+{
+    return html_parse_fd_parallel(fd, 1);
+}
+
+/**
+ * Reads the whole source behind the given file descriptor and parses it at
+ * 	once with the given number of threads.
+ *
+ * @param fd The file descriptor to read from.
+ * @param threads The number of threads to parse the source with.
+ * @return The head of the linked list containing the instructions or
+ * 	<code>NULL</code> if the source could not be parsed.
+ */
+HtmlInstruction *html_parse_fd_parallel(int fd, int threads)
+{
+    size_t length = 0, size = 65536;
+    char *buffer;
+    long count;
+    HtmlParseError error;
+    HtmlInstruction *root;
+#ifdef HTML_HAVE_MMAP
+    struct stat status;
+
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0 &&
+        (off_t)(size_t)status.st_size == status.st_size)
+    {
+        void *source = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (source != MAP_FAILED)
+        {
+#ifdef MADV_SEQUENTIAL
+            madvise(source, (size_t)status.st_size, MADV_SEQUENTIAL);
+#endif
+            root = html_parse_buffer_parallel((const char *)source, (size_t)status.st_size, threads, &error);
+            munmap(source, (size_t)status.st_size);
+            if (root == NULL)
+                html_print_parse_error(&error, 0);
+            return root;
+        }
+    }
+#endif
+
+    buffer = (char *)malloc(size);
+    while (buffer != NULL)
+    {
+        if (length == size)
+        {
+            char *larger = (char *)realloc(buffer, size * 2);
+            if (larger == NULL)
             {
-                if (temp == ch)
-                {
-                    instruction->difference++;
-                }
-                else
-                {
-                    instruction->difference--;
-                }
+                free(buffer);
+                buffer = NULL;
+                break;
             }
-            ungetc(temp, stream);
-            break;
-        case HTML_TOKEN_OUTPUT:
-        case HTML_TOKEN_INPUT:
-            while ((temp = fgetc(stream)) != until && temp == ch)
-                instruction->difference++;
-            ungetc(temp, stream);
-            break;
-        case HTML_TOKEN_LOOP_START:
-            instruction->loop = html_parse_stream_until(stream, until);
-            break;
-        case HTML_TOKEN_LOOP_END:
-            return root;
-        case HTML_TOKEN_BREAK:
-            break;
-        default:
-            continue;
+            buffer = larger;
+            size *= 2;
         }
-        instruction->next = (HtmlInstruction *)malloc(sizeof(HtmlInstruction));
-        instruction->next->next = 0;
-        instruction->next->loop = 0;
-        instruction = instruction->next;
+        count = (long)read(fd, buffer + length, size - length);
+        if (count < 0 && errno == EINTR)
+            continue;
+        /* Read errors end the source like the end of the file does */
+        if (count <= 0)
+            break;
+        length += (size_t)count;
     }
-    instruction->type = HTML_TOKEN_LOOP_END;
+    if (buffer == NULL)
+    {
+        error.type = HTML_PARSE_OUT_OF_MEMORY;
+        html_print_parse_error(&error, 0);
+        return NULL;
+    }
+    root = html_parse_buffer_parallel(buffer, length, threads, &error);
+    free(buffer);
+    if (root == NULL)
+        html_print_parse_error(&error, 0);
     return root;
 }
 
@@ -339,7 +854,8 @@ HtmlInstruction *html_parse_substring(char *str, int begin, int end)
  *	Since this will be used as counter, the value of the pointer will be increased.
  * @param end The index you want to stop parsing at.
  *	When <code>-1</code> is given, it will stop at the end of the string.
- * @param The head of the linked list containing the instructions.
+ * @return The head of the linked list containing the instructions or <code>NULL</code>
+ * 	if the program is malformed, in which case the error is reported on stderr.
  */
 HtmlInstruction *html_parse_substring_incremental(char *str, int *ptr, int end)
 {
@@ -347,271 +863,3981 @@ HtmlInstruction *html_parse_substring_incremental(char *str, int *ptr, int end)
         return NULL;
     if (end < 0)
         end = strlen(str);
-    HtmlInstruction *root = (HtmlInstruction *)malloc(sizeof(HtmlInstruction));
-    HtmlInstruction *instruction = root;
-    instruction->next = 0;
-    instruction->previous = 0;
-    instruction->loop = 0;
-    char c, temp_c;
-    for (; *ptr < end && (c = str[*ptr]); (*ptr)++)
+    size_t length = 0;
+    if (*ptr < end)
     {
-        instruction->type = c;
-        instruction->difference = 1;
-        switch (c)
-        {
-        case HTML_TOKEN_PLUS:
-        case HTML_TOKEN_MINUS:
-            (*ptr)++;
-            for (; *ptr < end && (temp_c = str[*ptr]) &&
-                   (temp_c == HTML_TOKEN_PLUS || temp_c == HTML_TOKEN_MINUS);
-                 (*ptr)++)
-            {
-                if (temp_c == c)
-                {
-                    instruction->difference++;
-                }
-                else
-                {
-                    instruction->difference--;
-                }
-            }
-            (*ptr)--;
-            break;
-        case HTML_TOKEN_NEXT:
-        case HTML_TOKEN_PREVIOUS:
-            (*ptr)++;
-            for (; *ptr < end && (temp_c = str[*ptr]) &&
-                   (temp_c == HTML_TOKEN_NEXT || temp_c == HTML_TOKEN_PREVIOUS);
-                 (*ptr)++)
-            {
-                if (temp_c == c)
-                {
-                    instruction->difference++;
-                }
-                else
-                {
-                    instruction->difference--;
-                }
-            }
-            (*ptr)--;
-            break;
-        case HTML_TOKEN_OUTPUT:
-        case HTML_TOKEN_INPUT:
-            (*ptr)++;
-            for (; *ptr < end && (str[*ptr] == c); (*ptr)++)
-            {
-                instruction->difference++;
-            }
-            (*ptr)--;
-            break;
-        case HTML_TOKEN_LOOP_START:
-            (*ptr)++;
-            instruction->loop = html_parse_substring_incremental(str, ptr, end);
-            break;
-        case HTML_TOKEN_LOOP_END:
-            return root;
-        case HTML_TOKEN_BREAK:
-            break;
-        default:
-            continue;
-        }
-        instruction->next = (HtmlInstruction *)malloc(sizeof(HtmlInstruction));
-        instruction->next->next = 0;
-        instruction->next->loop = 0;
-        instruction->next->previous = instruction;
-        instruction = instruction->next;
+        const char *terminator = (const char *)memchr(str + *ptr, '\0', end - *ptr);
+        length = terminator == NULL ? (size_t)(end - *ptr) : (size_t)(terminator - (str + *ptr));
+    }
+    HtmlParseError error;
+    HtmlInstruction *root = html_parse_buffer(str + (*ptr < end ? *ptr : 0), length, &error);
+    if (root == NULL)
+    {
+        html_print_parse_error(&error, *ptr);
+        *ptr += error.offset;
+        return NULL;
     }
-    instruction->type = HTML_TOKEN_LOOP_END;
+    *ptr += length;
     return root;
 }
 
+/*
+ * Every byte that is not a token is a comment. The tokens are the letters h, l,
+ * 	m and t in both cases, so a byte is a letter token exactly if setting its
+ * 	case bit (0x20) yields one of the lower case tokens. The break token is
+ * 	compared on its own, it only occurs in programs that use the debug
+ * 	extension.
+ */
+#define HTML_IS_TOKEN(c)                                                      \
+    (((c) | 0x20) == HTML_TOKEN_PLUS || ((c) | 0x20) == HTML_TOKEN_MINUS ||   \
+     ((c) | 0x20) == HTML_TOKEN_LOOP_START || ((c) | 0x20) == HTML_TOKEN_LOOP_END || \
+     (c) == HTML_TOKEN_BREAK)
+
 /**
- * Converts the given character to an instruction.
+ * Finds the first token at or after the given position, one byte at a time.
  *
- * @param c The character to convert.
- * @param The character that's converted into an instruction.
+ * @param buffer The buffer to search.
+ * @param position The position to start at.
+ * @param length The number of bytes in the buffer.
+ * @return The position of the token or <code>length</code> if there is none.
  */
-HtmlInstruction *html_parse_character(char c)
+static size_t html_next_token_scalar(const char *buffer, size_t position, size_t length)
 {
-    HtmlInstruction *instruction = (HtmlInstruction *)malloc(sizeof(HtmlInstruction));
-    instruction->next = 0;
-    instruction->loop = 0;
-    instruction->difference = 1;
-    switch (c)
-    {
-    case HTML_TOKEN_PLUS:
-    case HTML_TOKEN_MINUS:
-    case HTML_TOKEN_NEXT:
-    case HTML_TOKEN_PREVIOUS:
-    case HTML_TOKEN_OUTPUT:
-    case HTML_TOKEN_INPUT:
-    case HTML_TOKEN_LOOP_START:
+    for (; position < length; position++)
+        if (HTML_IS_TOKEN(buffer[position]))
+            return position;
+    return length;
+}
+
+#ifdef HTML_HAVE_X86_SIMD
+/* Whether the CPU runs the AVX2 kernels, looked up once when the library is loaded */
+static int html_has_avx2;
+
+/**
+ * Looks up the features of the CPU the kernels are selected by, before the
+ * 	lexer and the scans run for the first time.
+ */
+__attribute__((constructor)) static void html_detect_cpu(void)
+{
+    __builtin_cpu_init();
+    html_has_avx2 = __builtin_cpu_supports("avx2");
+}
+
+__attribute__((target("sse2"))) static size_t html_next_token_sse2(const char *buffer, size_t position,
+                                                                  size_t length)
+{
+    const __m128i fold = _mm_set1_epi8(0x20);
+    const __m128i plus = _mm_set1_epi8(HTML_TOKEN_PLUS);
+    const __m128i minus = _mm_set1_epi8(HTML_TOKEN_MINUS);
+    const __m128i loop_start = _mm_set1_epi8(HTML_TOKEN_LOOP_START);
+    const __m128i loop_end = _mm_set1_epi8(HTML_TOKEN_LOOP_END);
+    const __m128i breakpoint = _mm_set1_epi8(HTML_TOKEN_BREAK);
+    __m128i block, folded;
+    unsigned int mask;
+    for (; position + 16 <= length; position += 16)
+    {
+        block = _mm_loadu_si128((const __m128i *)(buffer + position));
+        folded = _mm_or_si128(block, fold);
+        mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, plus), _mm_cmpeq_epi8(folded, minus)),
+                         _mm_or_si128(_mm_cmpeq_epi8(folded, loop_start), _mm_cmpeq_epi8(folded, loop_end))),
+            _mm_cmpeq_epi8(block, breakpoint)));
+        if (mask)
+            return position + __builtin_ctz(mask);
+    }
+    return html_next_token_scalar(buffer, position, length);
+}
+
+__attribute__((target("avx2"))) static size_t html_next_token_avx2(const char *buffer, size_t position,
+                                                                  size_t length)
+{
+    const __m256i fold = _mm256_set1_epi8(0x20);
+    const __m256i plus = _mm256_set1_epi8(HTML_TOKEN_PLUS);
+    const __m256i minus = _mm256_set1_epi8(HTML_TOKEN_MINUS);
+    const __m256i loop_start = _mm256_set1_epi8(HTML_TOKEN_LOOP_START);
+    const __m256i loop_end = _mm256_set1_epi8(HTML_TOKEN_LOOP_END);
+    const __m256i breakpoint = _mm256_set1_epi8(HTML_TOKEN_BREAK);
+    __m256i block, folded;
+    unsigned int mask;
+    for (; position + 32 <= length; position += 32)
+    {
+        block = _mm256_loadu_si256((const __m256i *)(buffer + position));
+        folded = _mm256_or_si256(block, fold);
+        mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, plus), _mm256_cmpeq_epi8(folded, minus)),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(folded, loop_start),
+                                            _mm256_cmpeq_epi8(folded, loop_end))),
+            _mm256_cmpeq_epi8(block, breakpoint)));
+        if (mask)
+            return position + __builtin_ctz(mask);
+    }
+    return html_next_token_sse2(buffer, position, length);
+}
+#endif
+
+/**
+ * Finds the first token at or after the given position, skipping comments a
+ * 	block of bytes at a time when the CPU supports it.
+ *
+ * @param buffer The buffer to search.
+ * @param position The position to start at.
+ * @param length The number of bytes in the buffer.
+ * @return The position of the token or <code>length</code> if there is none.
+ */
+static size_t html_next_token(const char *buffer, size_t position, size_t length)
+{
+    /* Most comments between tokens are a single space or line break */
+    if (position < length && HTML_IS_TOKEN(buffer[position]))
+        return position;
+#ifdef HTML_HAVE_X86_SIMD
+    if (html_has_avx2)
+        return html_next_token_avx2(buffer, position, length);
+    return html_next_token_sse2(buffer, position, length);
+#else
+    return html_next_token_scalar(buffer, position, length);
+#endif
+}
+
+/**
+ * A block of instructions allocated after the first one of an arena.
+ */
+typedef struct HtmlArenaBlock
+{
+    /**
+	 * The block allocated before this one, or <code>NULL</code>.
+	 */
+    struct HtmlArenaBlock *next;
+} HtmlArenaBlock;
+
+/**
+ * Allocates instructions in the order they are requested from blocks that are
+ * 	released all at once. The arena is stored at the start of its first block,
+ * 	which is followed by the instructions of that block, so a small program
+ * 	takes a single allocation.
+ */
+typedef struct HtmlArena
+{
+    /**
+	 * The blocks allocated after the first one, newest first.
+	 */
+    HtmlArenaBlock *blocks;
+    /**
+	 * The next unused instruction of the newest block.
+	 */
+    HtmlInstruction *unused;
+    /**
+	 * The number of unused instructions left in the newest block.
+	 */
+    size_t available;
+    /**
+	 * The number of instructions the newest block holds.
+	 */
+    size_t capacity;
+    /**
+	 * The number of instructions that are allocated and not destroyed yet,
+	 * 	counted by the owner for an arena that has one.
+	 */
+    size_t live;
+    /**
+	 * The arena that counts the instructions of this one and releases it
+	 * 	with its own, or <code>NULL</code>. The arenas of the chunks of a
+	 * 	parallel parse are owned by the one of the first chunk.
+	 */
+    struct HtmlArena *owner;
+    /**
+	 * The arenas this one owns, linked through <code>sibling</code>.
+	 */
+    struct HtmlArena *owned;
+    struct HtmlArena *sibling;
+    /**
+	 * The first instruction of the program parsed into the arena, or
+	 * 	<code>NULL</code>. Destroying the program from it releases the arena
+	 * 	at once.
+	 */
+    HtmlInstruction *root;
+    /**
+	 * Whether the list functions linked instructions of the program to
+	 * 	others or unlinked them, after which its instructions are released
+	 * 	one by one.
+	 */
+    int mixed;
+} HtmlArena;
+
+/**
+ * Creates a new arena.
+ *
+ * @param size The number of instructions the arena is expected to hold, the
+ * 	first block holds up to <code>HTML_ARENA_SIZE</code> of them.
+ * @return The new arena or <code>NULL</code> if it could not be allocated.
+ */
+static HtmlArena *html_arena(size_t size)
+{
+    if (size < 16)
+        size = 16;
+    else if (size > HTML_ARENA_SIZE)
+        size = HTML_ARENA_SIZE;
+    HtmlArena *arena = (HtmlArena *)malloc(sizeof(HtmlArena) + size * sizeof(HtmlInstruction));
+    if (arena == NULL)
+        return NULL;
+    arena->blocks = 0;
+    arena->unused = (HtmlInstruction *)(arena + 1);
+    arena->available = arena->capacity = size;
+    arena->live = 0;
+    arena->owner = arena->owned = arena->sibling = 0;
+    arena->root = 0;
+    arena->mixed = 0;
+    return arena;
+}
+
+/**
+ * Finds the arena that counts the instructions of the given arena.
+ *
+ * @param arena The arena, may be <code>NULL</code>.
+ * @return The owner of the arena, or the arena itself if it has none.
+ */
+static HtmlArena *html_arena_owner(HtmlArena *arena)
+{
+    return arena != NULL && arena->owner != NULL ? arena->owner : arena;
+}
+
+/**
+ * Makes the given arena own another one, which is released with it.
+ *
+ * @param arena The arena that takes over the other one.
+ * @param other The arena to take over.
+ */
+static void html_arena_adopt(HtmlArena *arena, HtmlArena *other)
+{
+    other->owner = arena;
+    other->sibling = arena->owned;
+    arena->owned = other;
+    arena->live += other->live;
+    other->live = 0;
+}
+
+/**
+ * Marks the programs of the given instructions as mixed when they are linked
+ * 	to each other, or the program of the first one when it is unlinked.
+ *
+ * @param instruction The instruction that is linked or unlinked.
+ * @param other The instruction it is linked to, or <code>NULL</code> if it
+ * 	is unlinked.
+ */
+static void html_arena_mix(HtmlInstruction *instruction, HtmlInstruction *other)
+{
+    HtmlArena *arena = html_arena_owner(instruction->arena);
+    HtmlArena *other_arena = other == NULL ? NULL : html_arena_owner(other->arena);
+    if (other != NULL && arena == other_arena)
+        return;
+    if (arena != NULL)
+        arena->mixed = 1;
+    if (other_arena != NULL)
+        other_arena->mixed = 1;
+}
+
+/**
+ * Releases the given arena and every instruction allocated from it.
+ *
+ * @param arena The arena to release, may be <code>NULL</code>.
+ */
+static void html_arena_destroy(HtmlArena *arena)
+{
+    HtmlArenaBlock *block, *next;
+    HtmlArena *owned;
+    if (arena == NULL)
+        return;
+    while ((owned = arena->owned) != NULL)
+    {
+        arena->owned = owned->sibling;
+        owned->owned = 0;
+        html_arena_destroy(owned);
+    }
+    for (block = arena->blocks; block != NULL; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+    free(arena);
+}
+
+/**
+ * Allocates a new instruction that is not linked to any other instruction.
+ *
+ * @param arena The arena to allocate the instruction from, or <code>NULL</code>
+ * 	to allocate it on its own.
+ * @param type The type of the instruction.
+ * @return The new instruction or <code>NULL</code> if it could not be allocated.
+ */
+static HtmlInstruction *html_instruction(HtmlArena *arena, char type)
+{
+    HtmlInstruction *instruction;
+    if (arena == NULL)
+        instruction = (HtmlInstruction *)malloc(sizeof(HtmlInstruction));
+    else
+    {
+        if (arena->available == 0)
+        {
+            size_t size = arena->capacity * 2;
+            HtmlArenaBlock *block = (HtmlArenaBlock *)malloc(sizeof(HtmlArenaBlock) + size * sizeof(HtmlInstruction));
+            if (block == NULL)
+                return NULL;
+            block->next = arena->blocks;
+            arena->blocks = block;
+            arena->unused = (HtmlInstruction *)(block + 1);
+            arena->available = arena->capacity = size;
+        }
+        instruction = arena->unused++;
+        arena->available--;
+        html_arena_owner(arena)->live++;
+    }
+    if (instruction == NULL)
+        return NULL;
+    instruction->arena = arena;
+    instruction->type = type;
+    instruction->difference = 1;
+    instruction->next = 0;
+    instruction->previous = 0;
+    instruction->loop = 0;
+    instruction->offset = 0;
+    return instruction;
+}
+
+/**
+ * Reads the run of tokens at the given position of the given buffer. Runs of
+ * 	the same kind of token are folded into a single token with a difference,
+ * 	like the instructions they become.
+ *
+ * @param buffer The buffer to read from.
+ * @param position The position of the first token of the run, as returned by
+ * 	<code>html_next_token</code>.
+ * @param length The number of bytes in the buffer.
+ * @param type The location to store the type of the run at, 0 if there are no
+ * 	tokens left.
+ * @param difference The location to store the difference of the run at.
+ * @return The position after the run.
+ */
+static size_t html_lex(const char *buffer, size_t position, size_t length, char *type,
+                       int *difference)
+{
+    char c, temp;
+    if (position == length)
+    {
+        *type = 0;
+        return length;
+    }
+    c = buffer[position++];
+    *type = c;
+    *difference = 1;
+    switch (c)
+    {
+    case HTML_TOKEN_PLUS:
+    case HTML_TOKEN_MINUS:
+        for (; position < length && ((temp = buffer[position]) == HTML_TOKEN_PLUS ||
+                                     temp == HTML_TOKEN_MINUS);
+             position++)
+            *difference += temp == c ? 1 : -1;
+        break;
+    case HTML_TOKEN_NEXT:
+    case HTML_TOKEN_PREVIOUS:
+        for (; position < length && ((temp = buffer[position]) == HTML_TOKEN_NEXT ||
+                                     temp == HTML_TOKEN_PREVIOUS);
+             position++)
+            *difference += temp == c ? 1 : -1;
+        break;
+    case HTML_TOKEN_OUTPUT:
+    case HTML_TOKEN_INPUT:
+        for (; position < length && buffer[position] == c; position++)
+            (*difference)++;
+        break;
+    }
+    return position;
+}
+
+/**
+ * Counts the instructions the given part of a buffer is parsed into: one for
+ * 	every run of tokens and one more for the body of every loop, plus the
+ * 	instruction that ends the list. Counting stops at the size of the first
+ * 	block of an arena, so comments do not make it larger than the program
+ * 	needs and long programs are only read this far.
+ *
+ * @param buffer The buffer to read from.
+ * @param position The position to start at.
+ * @param length The position to stop at.
+ * @return The number of instructions, at most <code>HTML_ARENA_SIZE</code>.
+ */
+static size_t html_count_instructions(const char *buffer, size_t position, size_t length)
+{
+    size_t count = 1;
+    char type;
+    int difference;
+    while (count < HTML_ARENA_SIZE)
+    {
+        position = html_lex(buffer, html_next_token(buffer, position, length), length, &type, &difference);
+        if (type == 0)
+            break;
+        count += type == HTML_TOKEN_LOOP_START ? 2 : 1;
+    }
+    return count;
+}
+
+/**
+ * The state of the parser while it links tokens into instructions.
+ */
+typedef struct HtmlBuilder
+{
+    /**
+	 * The arena the instructions are allocated from.
+	 */
+    HtmlArena *arena;
+    /**
+	 * The head of the linked list that is being built.
+	 */
+    HtmlInstruction *root;
+    /**
+	 * The instruction the next token is stored in, which ends the current list.
+	 */
+    HtmlInstruction *instruction;
+    /**
+	 * The loops that are still open, innermost last.
+	 */
+    HtmlInstruction **loops;
+    /**
+	 * The byte offsets of the open loops.
+	 */
+    size_t *offsets;
+    /**
+	 * The number of open loops.
+	 */
+    size_t depth;
+    /**
+	 * The number of loops <code>loops</code> and <code>offsets</code> can hold.
+	 */
+    size_t loops_size;
+    /**
+	 * The reason building failed or <code>HTML_PARSE_OK</code>.
+	 */
+    HtmlParseError error;
+} HtmlBuilder;
+
+/**
+ * Initializes the given builder with an empty list.
+ *
+ * @param builder The builder to initialize.
+ * @param size The number of instructions the list is expected to hold.
+ */
+static void html_builder(HtmlBuilder *builder, size_t size)
+{
+    builder->arena = html_arena(size);
+    builder->root = builder->arena == NULL ? NULL : html_instruction(builder->arena, HTML_TOKEN_LOOP_END);
+    if (builder->root != NULL)
+        builder->arena->root = builder->root;
+    builder->instruction = builder->root;
+    builder->loops = 0;
+    builder->offsets = 0;
+    builder->depth = builder->loops_size = 0;
+    builder->error.type = builder->root == NULL ? HTML_PARSE_OUT_OF_MEMORY : HTML_PARSE_OK;
+    builder->error.offset = 0;
+}
+
+/**
+ * Appends the given run of tokens to the list that is being built.
+ *
+ * @param builder The builder to append to.
+ * @param type The type of the run.
+ * @param difference The difference of the run.
+ * @param offset The byte offset of the first token of the run.
+ * @return <code>HTML_PARSE_OK</code> or the reason building failed.
+ */
+static int html_build(HtmlBuilder *builder, char type, int difference, size_t offset)
+{
+    HtmlInstruction *instruction = builder->instruction;
+    switch (type)
+    {
+    case HTML_TOKEN_LOOP_START:
+        if (builder->depth == builder->loops_size)
+        {
+            size_t size = builder->loops_size ? builder->loops_size * 2 : 16;
+            HtmlInstruction **new_loops = (HtmlInstruction **)
+                realloc(builder->loops, size * sizeof(HtmlInstruction *));
+            size_t *new_offsets = new_loops == NULL ? NULL : (size_t *)realloc(builder->offsets, size * sizeof(size_t));
+            if (new_loops != NULL)
+                builder->loops = new_loops;
+            if (new_offsets == NULL)
+                return builder->error.type = HTML_PARSE_OUT_OF_MEMORY;
+            builder->offsets = new_offsets;
+            builder->loops_size = size;
+        }
+        instruction->type = type;
+        instruction->loop = html_instruction(builder->arena, HTML_TOKEN_LOOP_END);
+        if (instruction->loop == NULL)
+            return builder->error.type = HTML_PARSE_OUT_OF_MEMORY;
+        builder->loops[builder->depth] = instruction;
+        builder->offsets[builder->depth++] = offset;
+        builder->instruction = instruction->loop;
+        return HTML_PARSE_OK;
     case HTML_TOKEN_LOOP_END:
-    case HTML_TOKEN_BREAK:
+        if (builder->depth == 0)
+        {
+            builder->error.offset = offset;
+            return builder->error.type = HTML_PARSE_UNMATCHED_LOOP_END;
+        }
+        /* The current instruction stays behind as the end of the loop body */
+        instruction = builder->loops[--builder->depth];
         break;
     default:
+        instruction->type = type;
+        instruction->difference = difference;
+        break;
+    }
+    instruction->next = html_instruction(builder->arena, HTML_TOKEN_LOOP_END);
+    if (instruction->next == NULL)
+        return builder->error.type = HTML_PARSE_OUT_OF_MEMORY;
+    instruction->next->previous = instruction;
+    builder->instruction = instruction->next;
+    return HTML_PARSE_OK;
+}
+
+/**
+ * Finishes the list of the given builder and releases the builder.
+ *
+ * @param builder The builder to finish.
+ * @param error The location to store the reason of a failure at, may be <code>NULL</code>.
+ * @return The head of the linked list or <code>NULL</code> if building failed.
+ */
+static HtmlInstruction *html_build_finish(HtmlBuilder *builder, HtmlParseError *error)
+{
+    HtmlInstruction *root = builder->root;
+    if (builder->error.type == HTML_PARSE_OK && builder->depth > 0)
+    {
+        builder->error.type = HTML_PARSE_UNMATCHED_LOOP_START;
+        builder->error.offset = builder->offsets[builder->depth - 1];
+    }
+    free(builder->loops);
+    free(builder->offsets);
+
+    if (builder->error.type != HTML_PARSE_OK)
+    {
+        html_arena_destroy(builder->arena);
+        root = NULL;
+    }
+    if (error != NULL)
+        *error = builder->error;
+    return root;
+}
+
+/**
+ * Converts the given buffer into a linked list containing all instructions. Loops
+ * 	are matched with an explicit stack, so the nesting depth is only limited by
+ * 	the available memory.
+ *
+ * @param buffer The buffer to read from.
+ * @param length The number of bytes in the buffer.
+ * @param error The location to store the reason of a failure at, may be <code>NULL</code>.
+ * @return The head of the linked list containing the instructions or <code>NULL</code>
+ * 	if the program is malformed or memory ran out.
+ */
+HtmlInstruction *html_parse_buffer(const char *buffer, size_t length, HtmlParseError *error)
+{
+    HtmlBuilder builder;
+    size_t position = 0, offset;
+    char type;
+    int difference;
+
+    html_builder(&builder, html_count_instructions(buffer, 0, length));
+    while (builder.error.type == HTML_PARSE_OK)
+    {
+        offset = html_next_token(buffer, position, length);
+        position = html_lex(buffer, offset, length, &type, &difference);
+        if (type == 0 || html_build(&builder, type, difference, offset) != HTML_PARSE_OK)
+            break;
+    }
+    return html_build_finish(&builder, error);
+}
+
+/**
+ * A chain of instructions of one list, built by one thread of a parallel parse.
+ */
+typedef struct HtmlSegment
+{
+    /**
+	 * The first instruction of the chain.
+	 */
+    HtmlInstruction *head;
+    /**
+	 * The instruction the next token is stored in, which ends the chain.
+	 */
+    HtmlInstruction *tail;
+    /**
+	 * The pointer that refers to <code>tail</code>, or <code>NULL</code> if
+	 * 	<code>tail</code> is the head of the chain.
+	 */
+    HtmlInstruction **slot;
+} HtmlSegment;
+
+/**
+ * A part of the source that is parsed by one thread of a parallel parse.
+ *
+ * A chunk that closes loops it did not open is split into one segment per
+ * 	such loop end: the first one continues the list of the chunk before and
+ * 	every other one continues the list after the loop that is closed. Loops
+ * 	that are opened but not closed within the chunk are left open, and the
+ * 	last segment ends in the body of the innermost one.
+ */
+typedef struct HtmlParseChunk
+{
+    const char *buffer;
+    size_t begin;
+    size_t end;
+    /**
+	 * The arena the instructions of the chunk are allocated from, owned by
+	 * 	the thread that parses the chunk until the chunks are stitched.
+	 */
+    HtmlArena *arena;
+    HtmlSegment *segments;
+    size_t segments_length;
+    /**
+	 * The loops that are still open at the end of the chunk, innermost last.
+	 */
+    HtmlInstruction **loops;
+    size_t depth;
+    /**
+	 * The byte offset of the first token of the chunk, <code>end</code> if
+	 * 	the chunk has no tokens.
+	 */
+    size_t first;
+    /**
+	 * The byte offset after the last token of the chunk.
+	 */
+    size_t tail;
+    /**
+	 * Whether memory ran out while parsing the chunk.
+	 */
+    int failed;
+} HtmlParseChunk;
+
+/**
+ * Parses the given chunk into segments of linked instructions.
+ *
+ * @param argument The chunk to parse.
+ * @return <code>NULL</code>.
+ */
+static void *html_parse_chunk(void *argument)
+{
+    HtmlParseChunk *chunk = (HtmlParseChunk *)argument;
+    size_t position = chunk->begin, offset, segments_size = 0, loops_size = 0;
+    HtmlInstruction *instruction = NULL, **slot = NULL;
+    char type = HTML_TOKEN_LOOP_END;
+    int difference;
+
+    chunk->first = chunk->end;
+    if ((chunk->arena = html_arena(html_count_instructions(chunk->buffer, chunk->begin, chunk->end) + 1)) == NULL)
+    {
+        chunk->failed = 1;
+        return NULL;
+    }
+    while (type != 0)
+    {
+        if (type == HTML_TOKEN_LOOP_END && chunk->depth == 0)
+        {
+            /* Start a new segment, at the start of the chunk or after a loop it did not open */
+            if (chunk->segments_length == segments_size)
+            {
+                size_t size = segments_size ? segments_size * 2 : 16;
+                HtmlSegment *segments = (HtmlSegment *)realloc(chunk->segments, size * sizeof(HtmlSegment));
+                if (segments == NULL)
+                    break;
+                chunk->segments = segments;
+                segments_size = size;
+            }
+            if (instruction != NULL)
+            {
+                chunk->segments[chunk->segments_length - 1].tail = instruction;
+                chunk->segments[chunk->segments_length - 1].slot = slot;
+            }
+            if ((instruction = html_instruction(chunk->arena, HTML_TOKEN_LOOP_END)) == NULL)
+                break;
+            chunk->segments[chunk->segments_length].head = instruction;
+            chunk->segments[chunk->segments_length].tail = instruction;
+            chunk->segments[chunk->segments_length++].slot = NULL;
+            slot = NULL;
+        }
+        else if (type == HTML_TOKEN_LOOP_START)
+        {
+            if (chunk->depth == loops_size)
+            {
+                size_t size = loops_size ? loops_size * 2 : 16;
+                HtmlInstruction **loops = (HtmlInstruction **)realloc(chunk->loops, size * sizeof(HtmlInstruction *));
+                if (loops == NULL)
+                    break;
+                chunk->loops = loops;
+                loops_size = size;
+            }
+            instruction->type = type;
+            if ((instruction->loop = html_instruction(chunk->arena, HTML_TOKEN_LOOP_END)) == NULL)
+                break;
+            chunk->loops[chunk->depth++] = instruction;
+            slot = &instruction->loop;
+            instruction = instruction->loop;
+        }
+        else
+        {
+            if (type == HTML_TOKEN_LOOP_END)
+                instruction = chunk->loops[--chunk->depth];
+            else
+            {
+                instruction->type = type;
+                instruction->difference = difference;
+            }
+            if ((instruction->next = html_instruction(chunk->arena, HTML_TOKEN_LOOP_END)) == NULL)
+                break;
+            instruction->next->previous = instruction;
+            slot = &instruction->next;
+            instruction = instruction->next;
+        }
+
+        offset = html_next_token(chunk->buffer, position, chunk->end);
+        position = html_lex(chunk->buffer, offset, chunk->end, &type, &difference);
+        if (type == 0)
+            break;
+        if (chunk->first == chunk->end)
+            chunk->first = offset;
+        chunk->tail = position;
+    }
+    if (type != 0 || chunk->segments_length == 0)
+    {
+        chunk->failed = 1;
         return NULL;
     }
-    instruction->type = c;
-    return instruction;
+    chunk->segments[chunk->segments_length - 1].tail = instruction;
+    chunk->segments[chunk->segments_length - 1].slot = slot;
+    return NULL;
+}
+
+/**
+ * Folds the given run into the run before it if the serial parser would have
+ * 	read them as one run.
+ *
+ * @param previous The run before, may be <code>NULL</code>.
+ * @param instruction The run that follows it without any bytes in between.
+ * @return 1 if the run was folded, 0 otherwise.
+ */
+static int html_fold_run(HtmlInstruction *previous, const HtmlInstruction *instruction)
+{
+    if (previous == NULL)
+        return 0;
+    switch (previous->type)
+    {
+    case HTML_TOKEN_PLUS:
+    case HTML_TOKEN_MINUS:
+        if (instruction->type != HTML_TOKEN_PLUS && instruction->type != HTML_TOKEN_MINUS)
+            return 0;
+        break;
+    case HTML_TOKEN_NEXT:
+    case HTML_TOKEN_PREVIOUS:
+        if (instruction->type != HTML_TOKEN_NEXT && instruction->type != HTML_TOKEN_PREVIOUS)
+            return 0;
+        break;
+    case HTML_TOKEN_OUTPUT:
+    case HTML_TOKEN_INPUT:
+        if (instruction->type != previous->type)
+            return 0;
+        break;
+    default:
+        return 0;
+    }
+    previous->difference += instruction->type == previous->type ? instruction->difference
+                                                                : -instruction->difference;
+    return 1;
+}
+
+/**
+ * Converts the given buffer into a linked list containing all instructions,
+ * 	parsing it with the given number of threads. The buffer is split into one
+ * 	chunk per thread, which is tokenized, folded and linked in parallel. A
+ * 	prefix sum over the loop depths of the chunks checks the loops, after which
+ * 	the chunks are stitched together into the list <code>html_parse_buffer</code>
+ * 	returns. Malformed programs are parsed again serially to report the same
+ * 	error.
+ *
+ * @param buffer The buffer to read from.
+ * @param length The number of bytes in the buffer.
+ * @param threads The number of threads to parse the buffer with.
+ * @param error The location to store the reason of a failure at, may be <code>NULL</code>.
+ * @return The head of the linked list containing the instructions or <code>NULL</code>
+ * 	if the program is malformed or memory ran out.
+ */
+HtmlInstruction *html_parse_buffer_parallel(const char *buffer, size_t length, int threads,
+                                            HtmlParseError *error)
+{
+    HtmlParseChunk *chunks;
+    HtmlInstruction *root = NULL, *instruction = NULL, **slot = &root, *head;
+    HtmlInstruction **loops = 0;
+    HtmlSegment *segment;
+    size_t count, i, j, depth = 0, deepest = 1, end = length + 1;
+    int valid = 1;
+#ifdef HTML_HAVE_PTHREADS
+    pthread_t *workers;
+    int *started;
+#endif
+
+    if (threads <= 1 || length < 2)
+        return html_parse_buffer(buffer, length, error);
+    count = (size_t)threads < length ? (size_t)threads : length;
+    chunks = (HtmlParseChunk *)calloc(count, sizeof(HtmlParseChunk));
+    if (chunks == NULL)
+        return html_parse_buffer(buffer, length, error);
+    for (i = 0; i < count; i++)
+    {
+        chunks[i].buffer = buffer;
+        chunks[i].begin = length / count * i;
+        chunks[i].end = i + 1 == count ? length : length / count * (i + 1);
+    }
+
+#ifdef HTML_HAVE_PTHREADS
+    workers = (pthread_t *)malloc(count * sizeof(pthread_t));
+    started = (int *)calloc(count, sizeof(int));
+    /* The calling thread parses the first chunk, and every chunk without a worker */
+    for (i = 1; workers != NULL && started != NULL && i < count; i++)
+        started[i] = pthread_create(workers + i, NULL, &html_parse_chunk, chunks + i) == 0;
+    for (i = 0; i < count; i++)
+        if (started == NULL || !started[i])
+            html_parse_chunk(chunks + i);
+    for (i = 1; started != NULL && i < count; i++)
+        if (started[i])
+            pthread_join(workers[i], NULL);
+    free(workers);
+    free(started);
+#else
+    for (i = 0; i < count; i++)
+        html_parse_chunk(chunks + i);
+#endif
+
+    /* Every segment after the first one of a chunk closes a loop opened before the chunk */
+    for (i = 0; i < count && valid; i++)
+    {
+        valid = !chunks[i].failed && depth >= chunks[i].segments_length - 1;
+        depth += chunks[i].depth - (chunks[i].segments_length - 1);
+        if (depth > deepest)
+            deepest = depth;
+    }
+    if (valid && depth == 0)
+        loops = (HtmlInstruction **)malloc(deepest * sizeof(HtmlInstruction *));
+    if (loops == NULL)
+    {
+        for (i = 0; i < count; i++)
+        {
+            html_arena_destroy(chunks[i].arena);
+            free(chunks[i].segments);
+            free(chunks[i].loops);
+        }
+        free(chunks);
+        return html_parse_buffer(buffer, length, error);
+    }
+
+    /* The program is released as one, with the arena of the first chunk */
+    for (i = 1; i < count; i++)
+        html_arena_adopt(chunks[0].arena, chunks[i].arena);
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < chunks[i].segments_length; j++)
+        {
+            segment = chunks[i].segments + j;
+            head = segment->head;
+            if (j > 0)
+            {
+                /* The segment continues the list after the loop it closes */
+                loops[--depth]->next = head;
+                head->previous = loops[depth];
+                slot = segment->slot != NULL ? segment->slot : &loops[depth]->next;
+                instruction = segment->tail;
+                continue;
+            }
+            if (instruction == NULL)
+            {
+                root = head;
+                slot = segment->slot != NULL ? segment->slot : &root;
+                instruction = segment->tail;
+                continue;
+            }
+            /* A run cut at the end of the previous chunk continues in this one */
+            if (head != segment->tail && chunks[i].first == end &&
+                html_fold_run(instruction->previous, head))
+            {
+                head = head->next;
+                html_destroy_instruction(segment->head);
+            }
+            /* The first instruction of the segment takes the place of the open end */
+            *slot = head;
+            head->previous = instruction->previous;
+            html_destroy_instruction(instruction);
+            if (head != segment->tail)
+                slot = segment->slot;
+            instruction = segment->tail;
+        }
+        for (j = 0; j < chunks[i].depth; j++)
+            loops[depth++] = chunks[i].loops[j];
+        if (chunks[i].first != chunks[i].end)
+            end = chunks[i].tail;
+    }
+    free(loops);
+    chunks[0].arena->root = root;
+    for (i = 0; i < count; i++)
+    {
+        free(chunks[i].segments);
+        free(chunks[i].loops);
+    }
+    free(chunks);
+    if (error != NULL)
+    {
+        error->type = HTML_PARSE_OK;
+        error->offset = 0;
+    }
+    return root;
+}
+
+/**
+ * Converts the given character to an instruction.
+ *
+ * @param c The character to convert.
+ * @param The character that's converted into an instruction.
+ */
+HtmlInstruction *html_parse_character(char c)
+{
+    HtmlInstruction *instruction = (HtmlInstruction *)malloc(sizeof(HtmlInstruction));
+    instruction->arena = 0;
+    instruction->next = 0;
+    instruction->previous = 0;
+    instruction->loop = 0;
+    instruction->offset = 0;
+    instruction->difference = 1;
+    switch (c)
+    {
+    case HTML_TOKEN_PLUS:
+    case HTML_TOKEN_MINUS:
+    case HTML_TOKEN_NEXT:
+    case HTML_TOKEN_PREVIOUS:
+    case HTML_TOKEN_OUTPUT:
+    case HTML_TOKEN_INPUT:
+    case HTML_TOKEN_LOOP_START:
+    case HTML_TOKEN_LOOP_END:
+    case HTML_TOKEN_BREAK:
+        break;
+    default:
+        return NULL;
+    }
+    instruction->type = c;
+    return instruction;
+}
+
+/**
+ * Computes the multiplicative inverse of an odd number modulo 2^32, so the result
+ * 	is also the inverse modulo every smaller power of two.
+ *
+ * @param value The odd number to invert.
+ * @return The inverse of the number.
+ */
+static unsigned long html_inverse(unsigned long value)
+{
+    unsigned long inverse = value;
+    int i;
+    /* Every Newton iteration doubles the number of correct low bits */
+    for (i = 0; i < 4; i++)
+        inverse = (inverse * (2 - value * inverse)) & 0xFFFFFFFFUL;
+    return inverse;
+}
+
+/**
+ * Replaces the given loop by straight-line code if it is a multiplication loop
+ * 	like <code>hmLtttLttHHl</code>: a loop without input, output or nested loops
+ * 	that returns to the cell it started at and changes that cell by an odd
+ * 	amount. Such a loop runs <code>n</code> times, where <code>n</code> solves
+ * 	<code>cell + n * step = 0</code> modulo the cell size, so every other cell
+ * 	it touches is increased by the current cell times a constant factor. The loop
+ * 	becomes a <code>HTML_INSTRUCTION_MULTIPLY</code> instruction for every touched
+ * 	cell, followed by a <code>HTML_INSTRUCTION_SET</code> that clears the current
+ * 	cell. A loop that only changes the current cell, like <code>hml</code>, just
+ * 	becomes the clear.
+ *
+ * @param instruction The loop instruction to replace. It becomes the first
+ * 	instruction of the replacement.
+ * @return The <code>HTML_INSTRUCTION_SET</code> instruction that ends the
+ * 	replacement or <code>NULL</code> if the loop is left alone.
+ */
+static HtmlInstruction *html_optimize_loop(HtmlInstruction *instruction)
+{
+    HtmlInstruction *body, *next;
+    /* The cells touched by the loop body, relative to the current cell, in order */
+    int *offsets = 0, *deltas = 0;
+    size_t count = 0, size = 0, i;
+    int position = 0, step = 0, delta;
+
+    for (body = instruction->loop; body != NULL && body->type != HTML_TOKEN_LOOP_END; body = body->next)
+    {
+        switch (body->type)
+        {
+        case HTML_TOKEN_PLUS:
+        case HTML_TOKEN_MINUS:
+            delta = body->type == HTML_TOKEN_PLUS ? body->difference : -body->difference;
+            if (position == 0)
+            {
+                step += delta;
+                continue;
+            }
+            for (i = 0; i < count && offsets[i] != position; i++)
+            {
+            }
+            if (i == count)
+            {
+                if (count == size)
+                {
+                    size = size ? size * 2 : 8;
+                    int *new_offsets = (int *)realloc(offsets, size * sizeof(int));
+                    int *new_deltas = new_offsets == NULL ? NULL : (int *)realloc(deltas, size * sizeof(int));
+                    if (new_offsets != NULL)
+                        offsets = new_offsets;
+                    if (new_deltas == NULL)
+                        goto unchanged;
+                    deltas = new_deltas;
+                }
+                offsets[count] = position;
+                deltas[count++] = 0;
+            }
+            deltas[i] += delta;
+            continue;
+        case HTML_TOKEN_NEXT:
+            position += body->difference;
+            continue;
+        case HTML_TOKEN_PREVIOUS:
+            position -= body->difference;
+            continue;
+        default:
+            goto unchanged;
+        }
+    }
+    if (position != 0 || step % 2 == 0)
+        goto unchanged;
+
+    /* Allocate the whole replacement first, so a failure leaves the loop intact */
+    HtmlInstruction *chain = 0, *tail = 0;
+    for (i = 0; i < count; i++)
+    {
+        if ((next = html_instruction(instruction->arena, HTML_INSTRUCTION_SET)) == NULL)
+        {
+            html_destroy_instructions(chain);
+            goto unchanged;
+        }
+        if (tail == NULL)
+            chain = next;
+        else
+            tail->next = next;
+        next->previous = tail;
+        tail = next;
+    }
+    html_destroy_instructions(instruction->loop);
+    instruction->loop = 0;
+    if (chain != NULL)
+    {
+        tail->next = instruction->next;
+        if (tail->next != NULL)
+            tail->next->previous = tail;
+        instruction->next = chain;
+        chain->previous = instruction;
+    }
+
+    unsigned long inverse = html_inverse((unsigned long)-step & 0xFFFFFFFFUL), factor;
+    HtmlInstruction *replacement = instruction;
+    for (i = 0; i < count; i++)
+    {
+        factor = ((unsigned long)deltas[i] * inverse) & 0xFFFFFFFFUL;
+        replacement->type = HTML_INSTRUCTION_MULTIPLY;
+        replacement->offset = offsets[i];
+        replacement->difference = factor > 0x7FFFFFFFUL ? -(int)(0xFFFFFFFFUL - factor) - 1 : (int)factor;
+        replacement = replacement->next;
+    }
+    replacement->type = HTML_INSTRUCTION_SET;
+    replacement->difference = 0;
+    replacement->offset = 0;
+    free(offsets);
+    free(deltas);
+    return replacement;
+
+unchanged:
+    free(offsets);
+    free(deltas);
+    return NULL;
+}
+
+/**
+ * Determines whether the given loop instruction only moves the pointer until it
+ * 	finds a zero cell, like <code>hLl</code>, <code>hHl</code> and <code>hLLLl</code>.
+ *
+ * @param instruction The loop instruction to check.
+ * @return Nonzero if the loop is a scan.
+ */
+static int html_is_scan_loop(HtmlInstruction *instruction)
+{
+    HtmlInstruction *body = instruction->loop;
+    return body != NULL && (body->type == HTML_TOKEN_NEXT || body->type == HTML_TOKEN_PREVIOUS) &&
+           body->difference > 0 && (body->next == NULL || body->next->type == HTML_TOKEN_LOOP_END);
+}
+
+/**
+ * The part of a loop the range analysis has seen so far, relative to the cell
+ * 	the loop started its iteration on.
+ */
+typedef struct HtmlRange
+{
+    /**
+	 * The loop that is analyzed.
+	 */
+    HtmlInstruction *loop;
+    /**
+	 * The cell the pointer is at.
+	 */
+    long position;
+    /**
+	 * The lowest and the highest cell the pointer moved to or that was accessed.
+	 */
+    long low, high;
+    /**
+	 * Whether every instruction so far has a known effect on the pointer.
+	 */
+    int balanced;
+} HtmlRange;
+
+/**
+ * Marks every loop that ends each iteration on the cell it started at as a
+ * 	<code>HTML_INSTRUCTION_BALANCED_LOOP</code> and stores the lowest and the
+ * 	highest cell its body moves to or accesses, relative to that cell, in its
+ * 	offset and difference. A loop is only balanced if all loops in its body
+ * 	are, so scans and moves that depend on the tape leave the enclosing loops
+ * 	to the checks of every move.
+ *
+ * @param root The start of the linked list of instructions to analyze.
+ */
+static void html_analyze_ranges(HtmlInstruction *root)
+{
+    /* The loops that enclose the current one, innermost last */
+    HtmlRange *ranges = 0, current = {0, 0, 0, 0, 1};
+    size_t depth = 0, size = 0;
+    HtmlInstruction *instruction = root, *loop;
+
+    for (;;)
+    {
+        if (instruction == NULL || instruction->type == HTML_TOKEN_LOOP_END)
+        {
+            if (depth == 0)
+                break;
+            loop = current.loop;
+            current.balanced = current.balanced && current.position == 0 &&
+                               current.low >= INT_MIN && current.high <= INT_MAX;
+            if (current.balanced)
+            {
+                loop->type = HTML_INSTRUCTION_BALANCED_LOOP;
+                loop->offset = (int)current.low;
+                loop->difference = (int)current.high;
+            }
+            else
+                loop->type = HTML_TOKEN_LOOP_START;
+            /* The loop is a single step of the loop around it that does not move the pointer */
+            depth--;
+            ranges[depth].balanced = ranges[depth].balanced && current.balanced;
+            if (ranges[depth].position + current.low < ranges[depth].low)
+                ranges[depth].low = ranges[depth].position + current.low;
+            if (ranges[depth].position + current.high > ranges[depth].high)
+                ranges[depth].high = ranges[depth].position + current.high;
+            current = ranges[depth];
+            instruction = loop->next;
+            continue;
+        }
+        switch (instruction->type)
+        {
+        case HTML_TOKEN_NEXT:
+        case HTML_TOKEN_PREVIOUS:
+            /* html_execute reports runs that move against their own direction */
+            if (instruction->difference < 0)
+                current.balanced = 0;
+            current.position += instruction->type == HTML_TOKEN_NEXT ? instruction->difference
+                                                                     : -instruction->difference;
+            if (current.position < current.low)
+                current.low = current.position;
+            if (current.position > current.high)
+                current.high = current.position;
+            break;
+        case HTML_INSTRUCTION_MULTIPLY:
+            if (current.position + instruction->offset < current.low)
+                current.low = current.position + instruction->offset;
+            if (current.position + instruction->offset > current.high)
+                current.high = current.position + instruction->offset;
+            break;
+        case HTML_TOKEN_PLUS:
+        case HTML_TOKEN_MINUS:
+        case HTML_INSTRUCTION_SET:
+        case HTML_TOKEN_OUTPUT:
+        case HTML_TOKEN_INPUT:
+        case HTML_TOKEN_BREAK:
+            break;
+        case HTML_TOKEN_LOOP_START:
+        case HTML_INSTRUCTION_BALANCED_LOOP:
+            if (depth == size)
+            {
+                HtmlRange *larger;
+                size = size ? size * 2 : 16;
+                larger = (HtmlRange *)realloc(ranges, size * sizeof(HtmlRange));
+                if (larger == NULL)
+                {
+                    /* The loops that are marked already are analyzed completely */
+                    free(ranges);
+                    return;
+                }
+                ranges = larger;
+            }
+            ranges[depth++] = current;
+            current.loop = instruction;
+            current.position = current.low = current.high = 0;
+            current.balanced = 1;
+            instruction = instruction->loop;
+            continue;
+        default:
+            current.balanced = 0;
+            break;
+        }
+        instruction = instruction->next;
+    }
+    free(ranges);
+}
+
+/**
+ * Optimizes the given linked list containing instructions in place: loops that
+ * 	clear the current cell, like <code>hml</code>, and loops that add multiples of
+ * 	the current cell to nearby cells, like <code>hmLtttLttHHl</code>, are replaced
+ * 	by straight-line <code>HTML_INSTRUCTION_MULTIPLY</code> and
+ * 	<code>HTML_INSTRUCTION_SET</code> instructions. The additions that follow
+ * 	a clear are folded into it. Loops that move the pointer to the next zero
+ * 	cell, like <code>hLl</code>, become a single <code>HTML_INSTRUCTION_SCAN</code>.
+ * 	Loops that return to the cell they started at become a
+ * 	<code>HTML_INSTRUCTION_BALANCED_LOOP</code>, whose pointer range
+ * 	<code>html_execute</code> checks once when it enters the loop.
+ * 	The given instruction stays the start of the list. Loops whose bodies
+ * 	cannot be visited for lack of memory are left as they are.
+ *
+ * @param root The start of the linked list of instructions you want
+ * 	to optimize.
+ */
+void html_optimize(HtmlInstruction *root)
+{
+    /* The lists that still have to be visited */
+    HtmlInstruction **lists = 0;
+    size_t count = 0, size = 0;
+    HtmlInstruction *instruction = root, *next, *set;
+
+    for (;;)
+    {
+        if (instruction == NULL || instruction->type == HTML_TOKEN_LOOP_END)
+        {
+            if (count == 0)
+                break;
+            instruction = lists[--count];
+            continue;
+        }
+        if (instruction->type == HTML_TOKEN_LOOP_START && html_is_scan_loop(instruction))
+        {
+            instruction->type = HTML_INSTRUCTION_SCAN;
+            instruction->difference = instruction->loop->type == HTML_TOKEN_NEXT
+                                          ? instruction->loop->difference
+                                          : -instruction->loop->difference;
+            html_destroy_instructions(instruction->loop);
+            instruction->loop = 0;
+        }
+        else if (instruction->type == HTML_TOKEN_LOOP_START &&
+                 (set = html_optimize_loop(instruction)) != NULL)
+        {
+            instruction = set;
+            while ((next = instruction->next) != NULL &&
+                   (next->type == HTML_TOKEN_PLUS || next->type == HTML_TOKEN_MINUS))
+            {
+                instruction->difference += next->type == HTML_TOKEN_PLUS ? next->difference : -next->difference;
+                instruction->next = next->next;
+                if (next->next != NULL)
+                    next->next->previous = instruction;
+                html_destroy_instruction(next);
+            }
+        }
+        else if (instruction->type == HTML_TOKEN_LOOP_START && instruction->loop != NULL)
+        {
+            if (count == size)
+            {
+                HtmlInstruction **larger = (HtmlInstruction **)realloc(lists, (size ? size * 2 : 16) *
+                                                                                  sizeof(HtmlInstruction *));
+                /* Without memory the body stays as it is, which runs the same, only slower */
+                if (larger != NULL)
+                {
+                    lists = larger;
+                    size = size ? size * 2 : 16;
+                }
+            }
+            if (count < size)
+                lists[count++] = instruction->loop;
+        }
+        instruction = instruction->next;
+    }
+    free(lists);
+    html_analyze_ranges(root);
+}
+
+/**
+ * Destroys the given instruction.
+ * 
+ * @param instruction The instruction to destroy.
+ */
+void html_destroy_instruction(HtmlInstruction *instruction)
+{
+    if (instruction == NULL)
+        return;
+    if (instruction->arena == NULL)
+        free(instruction);
+    else if (--html_arena_owner(instruction->arena)->live == 0)
+        html_arena_destroy(html_arena_owner(instruction->arena));
+    instruction = 0;
+}
+
+/**
+ * Destroys a linked list containing instructions. A program destroyed from
+ * 	the instruction a parser returned is released with its arena in one call,
+ * 	unless <code>html_add</code>, <code>html_remove</code> or the other list
+ * 	functions linked it to other instructions or unlinked some of its own.
+ * 	Instructions unlinked from such a program by hand must be destroyed
+ * 	before it.
+ * 
+ * @param root The start of the instruction list.
+ */
+void html_destroy_instructions(HtmlInstruction *root)
+{
+    HtmlInstruction *tmp;
+    HtmlArena *arena = root == NULL ? NULL : html_arena_owner(root->arena);
+    /* A whole parsed program goes with its arena, without visiting its instructions */
+    if (arena != NULL && arena->root == root && !arena->mixed)
+    {
+        html_arena_destroy(arena);
+        return;
+    }
+    while (root != NULL)
+    {
+        if (root->loop != NULL)
+        {
+            /* Splice the loop body into the list instead of recursing into it */
+            tmp = root->loop;
+            while (tmp->next != NULL)
+                tmp = tmp->next;
+            tmp->next = root->next;
+            root->next = root->loop;
+            root->loop = 0;
+        }
+        tmp = root;
+        root = root->next;
+        html_destroy_instruction(tmp);
+    }
+}
+
+/**
+ * Destroys a state.
+ * 
+ * @param state The state to destroy
+ */
+void html_destroy_state(HtmlState *state)
+{
+    if (state == NULL)
+        return;
+    html_destroy_instructions(state->root);
+    state->head = 0;
+    state->root = 0;
+    free(state);
+    state = 0;
+}
+
+/**
+ * Destroys a context.
+ * 
+ * @param context The context to destroy
+ */
+void html_destroy_context(HtmlExecutionContext *context)
+{
+#ifdef HTML_HAVE_MMAP
+    if (context->tape_options & HTML_TAPE_GROWABLE)
+        munmap(context->tape - html_tape_start(context->tape_limit, context->tape_options, context->cell_size),
+               html_tape_mapping(context->tape_limit, context->tape_options, context->cell_size));
+    else
+#endif
+        free(context->tape);
+    html_destroy_page_table(context->tape_pages);
+    free(context->output_buffer);
+    free(context->input_buffer);
+    free(context);
+    context = 0;
+}
+
+/**
+ * Clears the cells of the given context that programs may have touched and
+ * 	moves the pointer back to cell 0, so the context can run the next program
+ * 	as if it was new. Only the cells between <code>tape_low</code> and
+ * 	<code>tape_size</code> are cleared, which the engines grow as programs
+ * 	reach further, and the pages a sparse tape accessed since the last reset.
+ * 	Guarded tapes give back the cells they committed after their first commit
+ * 	step, since their engines touch every committed cell without checks.
+ *
+ * @param context The context to reset.
+ */
+void html_context_reset(HtmlExecutionContext *context)
+{
+    int width = context->cell_size;
+    if (context->tape_pages != NULL)
+        html_page_release(context->tape_pages, width);
+    else
+    {
+        memset(context->tape - context->tape_low * width, 0, (context->tape_low + context->tape_size) * width);
+        context->tape_low = 0;
+        context->tape_size = html_tape_touched(context->tape_limit, context->tape_options);
+#ifdef HTML_HAVE_MMAP
+        if ((context->tape_options & HTML_TAPE_GUARDED) && context->tape_committed > context->tape_size &&
+            mprotect(context->tape + context->tape_size * width, (context->tape_committed - context->tape_size) * width,
+                     PROT_NONE) == 0)
+            context->tape_committed = context->tape_size;
+        if ((context->tape_options & HTML_TAPE_GUARDED) && context->tape_committed_low > 0 &&
+            mprotect(context->tape - context->tape_committed_low * width, context->tape_committed_low * width,
+                     PROT_NONE) == 0)
+            context->tape_committed_low = 0;
+        /* Cells that stay committed on a guarded tape stay within the reach of its engines */
+        if (context->tape_options & HTML_TAPE_GUARDED)
+        {
+            context->tape_size = context->tape_committed;
+            context->tape_low = context->tape_committed_low;
+        }
+#endif
+    }
+    context->tape_page = LONG_MAX;
+    context->tape_page_cells = 0;
+    context->tape_index = 0;
+    context->resume_program = 0;
+    context->resume_position = 0;
+    context->resume_serial = 0;
+    context->output_length = 0;
+}
+
+/**
+ * Passes the buffered output of the given context to its output sink, or to
+ * 	its output handler if it has no sink.
+ *
+ * @param context The context to flush the output of.
+ */
+int html_output_flush(HtmlExecutionContext *context)
+{
+    size_t i;
+    size_t length = context->output_length;
+    if (length == 0)
+        return 0;
+    context->output_length = 0;
+    if (context->output_sink == NULL)
+    {
+        for (i = 0; i < length; i++)
+            context->output_handler((unsigned char)context->output_buffer[i]);
+    }
+    else if (context->output_sink(context, context->output_buffer, length) < 0)
+        return -1;
+    return 0;
+}
+
+/**
+ * Ends the running execution with the given status, which html_execute or
+ * 	html_execute_program returns. The current tape index and the position
+ * 	the engine recorded last go into the status.
+ *
+ * @param context The context of the execution.
+ * @param code One of the <code>HTML_EXECUTION_*</code> error values.
+ */
+static void html_fail(HtmlExecutionContext *context, int code)
+{
+    context->status.code = code;
+    context->status.tape_index = context->tape_index;
+    HTML_UNWIND(*(HtmlUnwind *)context->unwind);
+}
+
+/**
+ * Flushes the output of the running execution, which ends with an I/O error
+ * 	if the output sink fails.
+ *
+ * @param context The context of the execution.
+ */
+static void html_flush_output(HtmlExecutionContext *context)
+{
+    if (html_output_flush(context) < 0)
+        html_fail(context, HTML_EXECUTION_IO_ERROR);
+}
+
+/**
+ * Makes the given context read its input in blocks from the given file
+ * 	descriptor instead of calling its input handler for every byte.
+ *
+ * @param context The context to read the input of.
+ * @param fd The file descriptor to read from.
+ * @return 0 on success, -1 if the buffer could not be allocated.
+ */
+int html_set_input_fd(HtmlExecutionContext *context, int fd)
+{
+    if (context->input_buffer == NULL)
+    {
+        context->input_buffer = (char *)malloc(HTML_INPUT_BUFFER_SIZE);
+        if (context->input_buffer == NULL)
+            return -1;
+    }
+    context->input_fd = fd;
+    context->input_source = 0;
+    context->input_data = context->input_buffer;
+    context->input_position = 0;
+    context->input_length = 0;
+    return 0;
+}
+
+/**
+ * Makes the given context read its input in blocks from the given callback
+ * 	instead of calling its input handler for every byte.
+ *
+ * @param context The context to read the input of.
+ * @param source The callback that reads the input.
+ * @return 0 on success, -1 if the buffer could not be allocated.
+ */
+int html_set_input_source(HtmlExecutionContext *context, HtmlInputSource source)
+{
+    if (html_set_input_fd(context, -1) < 0)
+        return -1;
+    context->input_source = source;
+    return 0;
+}
+
+/**
+ * Makes the given context read its input from the given memory buffer
+ * 	instead of calling its input handler for every byte.
+ *
+ * @param context The context to read the input of.
+ * @param data The input.
+ * @param length The number of bytes of input.
+ */
+void html_set_input_buffer(HtmlExecutionContext *context, const char *data, size_t length)
+{
+    context->input_fd = -1;
+    context->input_source = 0;
+    context->input_data = data;
+    context->input_position = 0;
+    context->input_length = length;
+}
+
+/**
+ * Refills the input buffer of the given context from its input source or its
+ * 	file descriptor.
+ *
+ * @param context The context to read the input of.
+ * @return The number of bytes read, 0 at the end of the input.
+ */
+static size_t html_input_fill(HtmlExecutionContext *context)
+{
+    long length;
+    if (context->input_source != NULL)
+        length = context->input_source(context, context->input_buffer, HTML_INPUT_BUFFER_SIZE);
+    else if (context->input_fd < 0)
+        return 0;
+    else
+    {
+        do
+            length = (long)read(context->input_fd, context->input_buffer, HTML_INPUT_BUFFER_SIZE);
+        while (length < 0 && errno == EINTR);
+    }
+    /* Read errors end the input */
+    if (length <= 0)
+        return 0;
+    context->input_data = context->input_buffer;
+    context->input_position = 0;
+    context->input_length = (size_t)length;
+    return (size_t)length;
+}
+
+/**
+ * Commits the cells of a growable tape on one side of cell 0 in steps of
+ * 	<code>HTML_TAPE_COMMIT_SIZE</code> cells.
+ *
+ * @param context The context of the execution.
+ * @param left Whether the cells lie before cell 0.
+ * @param size The number of cells on that side that have to be committed.
+ * @return 1 if they are committed now, 0 if they could not be.
+ */
+static int html_tape_commit(HtmlExecutionContext *context, int left, size_t size)
+{
+#ifdef HTML_HAVE_MMAP
+    size_t *committed = left ? &context->tape_committed_low : &context->tape_committed;
+    size_t step = (size + HTML_TAPE_COMMIT_SIZE - 1) / HTML_TAPE_COMMIT_SIZE * HTML_TAPE_COMMIT_SIZE;
+    unsigned char *start = left ? context->tape - step * context->cell_size
+                                : context->tape + *committed * context->cell_size;
+    if (!(context->tape_options & HTML_TAPE_GROWABLE) ||
+        mprotect(start, (step - *committed) * context->cell_size, PROT_READ | PROT_WRITE) != 0)
+        return 0;
+    *committed = step < context->tape_limit ? step : context->tape_limit;
+    return 1;
+#else
+    (void)context;
+    (void)left;
+    (void)size;
+    return 0;
+#endif
+}
+
+/**
+ * Grows the part of the tape that programs touched up to the given cell, in
+ * 	steps of <code>HTML_TAPE_TOUCH_SIZE</code> cells, so the bounds checks of
+ * 	the engines only call this every few pages and
+ * 	<code>html_context_reset</code> knows which cells to clear. Growable
+ * 	tapes commit the cells on the way, and guarded tapes, whose engines do
+ * 	not check the bounds, count all cells they commit as touched. A
+ * 	bidirectional tape grows to the left for negative cells as well.
+ *
+ * @param context The context of the execution.
+ * @param cell The index of the cell the program moves to or accesses.
+ * @return 1 if the cell is on the tape now, 0 if it lies past its limit.
+ */
+static int html_tape_extend(HtmlExecutionContext *context, long cell)
+{
+    size_t step = context->tape_options & HTML_TAPE_GUARDED ? HTML_TAPE_COMMIT_SIZE : HTML_TAPE_TOUCH_SIZE;
+    size_t size;
+    int left = cell < 0;
+    if (context->tape_pages != NULL || cell >= (long)context->tape_limit)
+        return 0;
+    if (left && (!(context->tape_options & HTML_TAPE_BIDIRECTIONAL) || -cell > (long)context->tape_limit))
+        return 0;
+    if (left ? (size_t)-cell <= context->tape_low : (size_t)cell < context->tape_size)
+        return 1;
+    /* Cell -1 is the first one before cell 0 like cell 0 is the first one after it */
+    size = ((size_t)(left ? -cell - 1 : cell) / step + 1) * step;
+    if (size > context->tape_limit)
+        size = context->tape_limit;
+    if (size > (left ? context->tape_committed_low : context->tape_committed) && !html_tape_commit(context, left, size))
+        return 0;
+    if (left)
+        context->tape_low = size;
+    else
+        context->tape_size = size;
+    return 1;
+}
+
+/**
+ * Finds the given cell of a sparse tape, allocating its page on first access,
+ * 	and makes its page the one the context keeps at hand.
+ *
+ * @param context The context of the execution.
+ * @param cell The index of the cell, which must lie on the tape.
+ * @return The cell.
+ */
+static unsigned char *html_sparse_cell(HtmlExecutionContext *context, long cell)
+{
+    /* Shifts round negative cells down as well, so page -1 holds cells -1 and below */
+    long number = cell >> HTML_TAPE_PAGE_SHIFT;
+    unsigned char *cells = html_page_find(context->tape_pages, number);
+    if (cells == NULL)
+        cells = html_page_add(context->tape_pages, number, context->cell_size);
+    if (cells == NULL)
+    {
+        /* The engines keep the current cell to themselves, so report the cell that was accessed */
+        context->status.position = HTML_POSITION_UNKNOWN;
+        context->tape_index = (int)cell;
+        html_fail(context, HTML_EXECUTION_OUT_OF_MEMORY);
+    }
+    context->tape_page = number;
+    context->tape_page_cells = cells;
+    return cells + (cell & (HTML_TAPE_PAGE_SIZE - 1)) * context->cell_size;
+}
+
+/* The given cell of a sparse tape with cells of the given type, straight from the page at hand when it is on it */
+#define HTML_SPARSE_CELL(context, cell, type)                                                  \
+    ((cell) >> HTML_TAPE_PAGE_SHIFT == (context)->tape_page                                     \
+         ? (type *)(context)->tape_page_cells + ((cell) & (HTML_TAPE_PAGE_SIZE - 1))            \
+         : (type *)html_sparse_cell(context, cell))
+
+/**
+ * Finds the given cell of the tape of any kind, used where speed does not matter.
+ *
+ * @param context The context of the execution.
+ * @param cell The index of the cell, which must lie on the tape.
+ * @return The cell.
+ */
+static unsigned char *html_cell(HtmlExecutionContext *context, long cell)
+{
+    if (context->tape_pages != NULL)
+        return html_sparse_cell(context, cell);
+    return context->tape + cell * context->cell_size;
+}
+
+/**
+ * Reads a cell of the given size.
+ *
+ * @param cell The cell.
+ * @param width The size of the cell in bytes.
+ * @return The value of the cell.
+ */
+static unsigned int html_load(const unsigned char *cell, int width)
+{
+    if (width == 4)
+        return *(const unsigned int *)cell;
+    if (width == 2)
+        return *(const unsigned short *)cell;
+    return *cell;
+}
+
+/**
+ * Writes a cell of the given size, keeping the low bits of the value that fit.
+ *
+ * @param cell The cell.
+ * @param width The size of the cell in bytes.
+ * @param value The new value of the cell.
+ */
+static void html_store(unsigned char *cell, int width, unsigned int value)
+{
+    if (width == 4)
+        *(unsigned int *)cell = value;
+    else if (width == 2)
+        *(unsigned short *)cell = (unsigned short)value;
+    else
+        *cell = (unsigned char)value;
+}
+
+/**
+ * Ends the running execution because the tape pointer moved past the end of the tape.
+ *
+ * @param context The context of the execution.
+ */
+static void html_tape_overrun(HtmlExecutionContext *context)
+{
+    html_fail(context, HTML_EXECUTION_OVERRUN);
+}
+
+/**
+ * Ends the running execution because the tape pointer moved before the start of the tape.
+ *
+ * @param context The context of the execution.
+ */
+static void html_tape_underrun(HtmlExecutionContext *context)
+{
+    html_fail(context, HTML_EXECUTION_UNDERRUN);
+}
+
+/**
+ * Appends the given cell value to the output buffer the given number of times.
+ *
+ * @param context The context of the execution.
+ * @param value The value of the cell.
+ * @param count The number of times the value is written.
+ */
+static void html_output(HtmlExecutionContext *context, unsigned char value, int count)
+{
+    size_t length;
+    while (count > 0)
+    {
+        if (context->output_length == context->output_capacity)
+        {
+            html_flush_output(context);
+            /* Without a buffer, bytes go to the handler directly, a sink cannot take them */
+            if (context->output_capacity == 0 && context->output_sink != NULL)
+                html_fail(context, HTML_EXECUTION_IO_ERROR);
+            if (context->output_capacity == 0)
+            {
+                context->output_handler(value);
+                count--;
+                continue;
+            }
+        }
+        length = context->output_capacity - context->output_length;
+        if (length > (size_t)count)
+            length = (size_t)count;
+        memset(context->output_buffer + context->output_length, value, length);
+        context->output_length += length;
+        count -= (int)length;
+    }
+}
+
+/**
+ * Reads the given number of characters into a cell, from the input data of the
+ * 	context if it has any and with its input handler otherwise.
+ *
+ * @param context The context of the execution.
+ * @param cell The cell to store the characters in.
+ * @param count The number of characters to read.
+ */
+static void html_input(HtmlExecutionContext *context, unsigned char *cell, int count)
+{
+    int i;
+    int width = context->cell_size;
+    size_t available;
+    html_flush_output(context);
+    if (context->input_data != NULL)
+    {
+        /* Every character overwrites the previous one, so only the last one is stored */
+        while (count > 0)
+        {
+            available = context->input_length - context->input_position;
+            if (available == 0 && (available = html_input_fill(context)) == 0)
+            {
+                if (context->eof_behavior != HTML_EOF_UNCHANGED)
+                    html_store(cell, width, (unsigned int)context->eof_behavior);
+                return;
+            }
+            if (available > (size_t)count)
+                available = (size_t)count;
+            context->input_position += available;
+            html_store(cell, width, (unsigned char)context->input_data[context->input_position - 1]);
+            count -= (int)available;
+        }
+        return;
+    }
+    for (i = 0; i < count; i++)
+    {
+        char input = context->input_handler();
+        if (input == EOF)
+        {
+            if (context->eof_behavior != HTML_EOF_UNCHANGED)
+                html_store(cell, width, (unsigned int)context->eof_behavior);
+        }
+        else
+        {
+            html_store(cell, width, (unsigned char)input);
+        }
+    }
+}
+
+/**
+ * Charges the fuel slice the engine used up and hands it the next one, the
+ * 	number of loop back edges it may take before it calls this again. The
+ * 	stop requests are looked at here as well, which keeps both out of the
+ * 	operations of the engines.
+ *
+ * @param context The context of the execution.
+ * @return The size of the next slice, 0 if the program has to stop.
+ */
+static long html_fuel_refill(HtmlExecutionContext *context)
+{
+    long slice = HTML_FUEL_SLICE;
+    if (context->fuel != HTML_FUEL_UNLIMITED)
+    {
+        context->fuel -= context->fuel_slice;
+        if (context->fuel < slice)
+            slice = context->fuel;
+    }
+    if (context->shouldStop == 1)
+        slice = 0;
+    context->fuel_slice = slice;
+    return slice;
+}
+
+/**
+ * Charges the part of its fuel slice an engine used when it ends.
+ *
+ * @param context The context of the execution.
+ * @param budget The number of back edges the engine had left in the slice.
+ */
+static void html_fuel_return(HtmlExecutionContext *context, long budget)
+{
+    if (context->fuel != HTML_FUEL_UNLIMITED && context->fuel_slice > 0)
+        context->fuel -= context->fuel_slice - budget;
+    context->fuel_slice = 0;
+}
+
+/**
+ * Records where a compiled program stopped, so its next execution continues
+ * 	there.
+ *
+ * @param context The context of the execution.
+ * @param program The program that stopped.
+ * @param position The operation to continue at.
+ */
+static void html_halt(HtmlExecutionContext *context, const HtmlProgram *program, size_t position)
+{
+    context->resume_program = program;
+    context->resume_position = position;
+    context->resume_serial = program->serial;
+}
+
+/**
+ * Tells why an execution ended.
+ *
+ * @param context The context of the execution.
+ * @param halted Whether the execution ended before the end of the program.
+ * @return One of the <code>HTML_EXECUTION_*</code> values.
+ */
+static int html_execution_status(const HtmlExecutionContext *context, int halted)
+{
+    if (!halted)
+        return HTML_EXECUTION_DONE;
+    return context->shouldStop == 1 ? HTML_EXECUTION_STOPPED : HTML_EXECUTION_OUT_OF_FUEL;
+}
+
+/**
+ * Executes the basic block behind the given failed <code>HTML_OP_CHECK</code>
+ * 	operation one operation at a time and reports the first access outside of
+ * 	the tape, after the effects of the operations before it, exactly like the
+ * 	moves the block was compiled from would have.
+ *
+ * @param context The context of the execution.
+ * @param op The check operation.
+ * @param index The index of the current cell.
+ * @return The last operation that was executed.
+ */
+static const HtmlOp *html_execute_block_checked(HtmlExecutionContext *context, const HtmlOp *op,
+                                                long index)
+{
+    long cell;
+    for (op++;; op++)
+    {
+        switch (op->type)
+        {
+        case HTML_OP_ADD:
+        case HTML_OP_SET:
+        case HTML_OP_OUTPUT:
+        case HTML_OP_INPUT:
+            break;
+        default:
+            return op - 1;
+        }
+        context->status.position++;
+        cell = index + op->offset;
+        context->tape_index = (int)index;
+        if ((cell >= (long)context->tape_size || cell < -(long)context->tape_low) &&
+            !html_tape_extend(context, cell))
+        {
+            if (cell < 0)
+                html_tape_underrun(context);
+            html_tape_overrun(context);
+        }
+        switch (op->type)
+        {
+        case HTML_OP_ADD:
+            html_store(html_cell(context, cell), context->cell_size,
+                       html_load(html_cell(context, cell), context->cell_size) + op->difference);
+            break;
+        case HTML_OP_SET:
+            html_store(html_cell(context, cell), context->cell_size, (unsigned int)op->difference);
+            break;
+        case HTML_OP_OUTPUT:
+            html_output(context, (unsigned char)html_load(html_cell(context, cell), context->cell_size),
+                        op->difference);
+            break;
+        case HTML_OP_INPUT:
+            html_input(context, html_cell(context, cell), op->difference);
+            break;
+        }
+    }
+}
+
+/**
+ * Finds the first zero cell at or after the given index in steps of the given stride.
+ *
+ * @param tape The cells to search.
+ * @param index The index to start at.
+ * @param size The number of cells.
+ * @param stride The distance between the cells that are checked.
+ * @return The index of the zero cell or <code>-1</code> if there is none.
+ */
+static long html_scan_forward_scalar(const unsigned char *tape, long index, long size, int stride)
+{
+    for (; index < size; index += stride)
+        if (!tape[index])
+            return index;
+    return -1;
+}
+
+/**
+ * Finds the last zero cell at or before the given index in steps of the given stride.
+ *
+ * @param tape The cells to search.
+ * @param index The index to start at.
+ * @param stride The distance between the cells that are checked.
+ * @return The index of the zero cell or <code>-1</code> if there is none.
+ */
+static long html_scan_backward_scalar(const unsigned char *tape, long index, int stride)
+{
+    for (; index >= 0; index -= stride)
+        if (!tape[index])
+            return index;
+    return -1;
+}
+
+/**
+ * Finds the first zero cell at or after the given index like
+ * 	<code>html_scan_forward_scalar</code>, on cells of any size.
+ *
+ * @param tape The cells to search.
+ * @param index The index to start at.
+ * @param size The number of cells.
+ * @param stride The distance between the cells that are checked.
+ * @param width The size of a cell in bytes.
+ * @return The index of the zero cell or <code>-1</code> if there is none.
+ */
+static long html_scan_forward_cells(const unsigned char *tape, long index, long size, int stride, int width)
+{
+    for (; index < size; index += stride)
+        if (!html_load(tape + index * width, width))
+            return index;
+    return -1;
+}
+
+/**
+ * Finds the last zero cell at or before the given index like
+ * 	<code>html_scan_backward_scalar</code>, on cells of any size.
+ *
+ * @param tape The cells to search.
+ * @param index The index to start at.
+ * @param stride The distance between the cells that are checked.
+ * @param width The size of a cell in bytes.
+ * @return The index of the zero cell or <code>-1</code> if there is none.
+ */
+static long html_scan_backward_cells(const unsigned char *tape, long index, int stride, int width)
+{
+    for (; index >= 0; index -= stride)
+        if (!html_load(tape + index * width, width))
+            return index;
+    return -1;
+}
+
+#ifdef HTML_HAVE_X86_SIMD
+/*
+ * The vector kernels compare a whole block of cells against zero and mask out
+ * 	the cells that are not a multiple of the stride away from the start. A block
+ * 	holds the cells at 0, stride, 2 * stride, ... below the block width, and the
+ * 	next block starts at the first multiple of the stride past the width, so
+ * 	the same mask applies to every block.
+ */
+
+__attribute__((target("sse2"))) static long html_scan_forward_sse2(const unsigned char *tape, long index,
+                                                                  long size, int stride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    unsigned int pattern = 0, mask;
+    int span;
+    for (span = 0; span < 16; span += stride)
+        pattern |= 1u << span;
+    for (; index + 16 <= size; index += span)
+    {
+        mask = (unsigned int)_mm_movemask_epi8(
+                   _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(tape + index)), zero)) &
+               pattern;
+        if (mask)
+            return index + __builtin_ctz(mask);
+    }
+    return html_scan_forward_scalar(tape, index, size, stride);
+}
+
+__attribute__((target("sse2"))) static long html_scan_backward_sse2(const unsigned char *tape, long index,
+                                                                   int stride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    unsigned int pattern = 0, mask;
+    int span;
+    for (span = 0; span < 16; span += stride)
+        pattern |= 1u << (15 - span);
+    for (; index >= 15; index -= span)
+    {
+        mask = (unsigned int)_mm_movemask_epi8(
+                   _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(tape + index - 15)), zero)) &
+               pattern;
+        if (mask)
+            return index - 15 + (31 - __builtin_clz(mask));
+    }
+    return html_scan_backward_scalar(tape, index, stride);
+}
+
+__attribute__((target("avx2"))) static long html_scan_forward_avx2(const unsigned char *tape, long index,
+                                                                  long size, int stride)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned int pattern = 0, mask;
+    int span;
+    for (span = 0; span < 32; span += stride)
+        pattern |= 1u << span;
+    for (; index + 32 <= size; index += span)
+    {
+        mask = (unsigned int)_mm256_movemask_epi8(
+                   _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(tape + index)), zero)) &
+               pattern;
+        if (mask)
+            return index + __builtin_ctz(mask);
+    }
+    return html_scan_forward_scalar(tape, index, size, stride);
+}
+
+__attribute__((target("avx2"))) static long html_scan_backward_avx2(const unsigned char *tape, long index,
+                                                                   int stride)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned int pattern = 0, mask;
+    int span;
+    for (span = 0; span < 32; span += stride)
+        pattern |= 1u << (31 - span);
+    for (; index >= 31; index -= span)
+    {
+        mask = (unsigned int)_mm256_movemask_epi8(
+                   _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(tape + index - 31)), zero)) &
+               pattern;
+        if (mask)
+            return index - 31 + (31 - __builtin_clz(mask));
+    }
+    return html_scan_backward_scalar(tape, index, stride);
+}
+#endif
+
+/**
+ * Moves the tape pointer over a sparse tape like <code>html_scan</code>,
+ * 	without allocating the pages it passes. A page that was never accessed
+ * 	is all zero, so the scan stops at the first cell it reaches on it.
+ *
+ * @param context The context of the execution.
+ * @param index The index of the current cell.
+ * @param stride The number of cells to move at once, negative to the left.
+ * @return The index of the zero cell.
+ */
+static long html_sparse_scan(HtmlExecutionContext *context, long index, int stride)
+{
+    long low = -(long)context->tape_low;
+    long size = (long)context->tape_size;
+    const unsigned char *cells;
+    long first;
+
+    if (index < low || index >= size)
+    {
+        context->tape_index = (int)index;
+        if (index < 0)
+            html_tape_underrun(context);
+        html_tape_overrun(context);
+    }
+    for (;;)
+    {
+        cells = html_page_find(context->tape_pages, index >> HTML_TAPE_PAGE_SHIFT);
+        if (cells == NULL)
+            return index;
+        first = index >> HTML_TAPE_PAGE_SHIFT << HTML_TAPE_PAGE_SHIFT;
+        /* Scan to the end of the page, then look the next page up */
+        while (index >= first && index < first + HTML_TAPE_PAGE_SIZE)
+        {
+            if (!html_load(cells + (index - first) * context->cell_size, context->cell_size))
+                return index;
+            if (index + stride >= size || index + stride < low)
+            {
+                context->tape_index = (int)index;
+                if (stride < 0)
+                    html_tape_underrun(context);
+                html_tape_overrun(context);
+            }
+            index += stride;
+        }
+    }
+}
+
+/**
+ * Moves the tape pointer in steps of the given stride until it points at a zero
+ * 	cell, like the loops <code>hLl</code>, <code>hHl</code> and <code>hLLLl</code>
+ * 	do. Running past either end of the tape is reported exactly like the moves
+ * 	of the loop would have reported it.
+ *
+ * @param context The context of the execution.
+ * @param index The index of the current cell.
+ * @param stride The number of cells to move at once, negative to the left.
+ * @return The index of the zero cell.
+ */
+static long html_scan(HtmlExecutionContext *context, long index, int stride)
+{
+    if (context->tape_pages != NULL)
+        return html_sparse_scan(context, index, stride);
+    /* The scans run on the committed cells, which a bidirectional tape has before cell 0 too */
+    long low = (long)context->tape_low;
+    int width = context->cell_size;
+    const unsigned char *tape = context->tape - low * width;
+    long size = (long)context->tape_size + low;
+    long found;
+    const unsigned char *zero;
+
+    /* The engines without bounds checks only check the cell a scan starts at here */
+    if ((index < -low || index + low >= size) && !html_tape_extend(context, index))
+    {
+        context->tape_index = (int)index;
+        if (index < 0)
+            html_tape_underrun(context);
+        html_tape_overrun(context);
+    }
+    low = (long)context->tape_low;
+    tape = context->tape - low * width;
+    size = (long)context->tape_size + low;
+    index += low;
+    if (stride > 0)
+    {
+        /* The vector kernels and the byte searches only know cells of one byte */
+        if (width != 1)
+            found = html_scan_forward_cells(tape, index, size, stride, width);
+        else if (stride == 1)
+        {
+            zero = (const unsigned char *)memchr(tape + index, 0, size - index);
+            found = zero == NULL ? -1 : zero - tape;
+        }
+#ifdef HTML_HAVE_X86_SIMD
+        else if (stride <= 32 && html_has_avx2)
+            found = html_scan_forward_avx2(tape, index, size, stride);
+        else if (stride <= 16)
+            found = html_scan_forward_sse2(tape, index, size, stride);
+#endif
+        else
+            found = html_scan_forward_scalar(tape, index, size, stride);
+        /* The cells a growable tape has not committed yet are all zero */
+        if (found < 0)
+        {
+            found = index + (size - index + stride - 1) / stride * stride;
+            if (!html_tape_extend(context, found - low))
+            {
+                context->tape_index = (int)(index + (size - 1 - index) / stride * stride - low);
+                html_tape_overrun(context);
+            }
+        }
+    }
+    else
+    {
+        stride = -stride;
+        if (width != 1)
+            found = html_scan_backward_cells(tape, index, stride, width);
+        else if (stride == 1)
+        {
+#ifdef __GLIBC__
+            zero = (const unsigned char *)memrchr(tape, 0, index + 1);
+            found = zero == NULL ? -1 : zero - tape;
+#else
+            found = html_scan_backward_scalar(tape, index, 1);
+#endif
+        }
+#ifdef HTML_HAVE_X86_SIMD
+        else if (stride <= 32 && html_has_avx2)
+            found = html_scan_backward_avx2(tape, index, stride);
+        else if (stride <= 16)
+            found = html_scan_backward_sse2(tape, index, stride);
+#endif
+        else
+            found = html_scan_backward_scalar(tape, index, stride);
+        if (found < 0)
+        {
+            found = index % stride - stride;
+            if (!html_tape_extend(context, found - low))
+            {
+                context->tape_index = (int)(index % stride - low);
+                html_tape_underrun(context);
+            }
+        }
+    }
+    return found - low;
+}
+
+/**
+ * Prints the cells around the tape pointer, used by the debug extension.
+ *
+ * @param context The context of the execution.
+ */
+static void html_print_tape(HtmlExecutionContext *context)
+{
+    int index;
+    html_flush_output(context);
+    int low = context->tape_index - 10;
+    if (low < -(int)context->tape_low)
+        low = -(int)context->tape_low;
+    int high = low + 21;
+    if (high >= (int)context->tape_size)
+        high = context->tape_size - 1;
+    for (index = low; index < high; index++)
+        printf("%i\t", index);
+    printf("\n");
+    for (index = low; index < high; index++)
+        printf("%u\t", html_load(html_cell(context, index), context->cell_size));
+    printf("\n");
+    for (index = low; index < high; index++)
+        if (index == context->tape_index)
+            printf("^\t");
+        else
+            printf(" \t");
+    printf("\n");
+}
+
+/**
+ * The loops the tree interpreter is currently in.
+ */
+typedef struct HtmlLoopStack
+{
+    /**
+	 * The loop instructions, innermost last.
+	 */
+    HtmlInstruction **loops;
+    /**
+	 * The number of loops on the stack.
+	 */
+    size_t depth;
+    /**
+	 * The number of loops the stack can hold.
+	 */
+    size_t size;
+    /**
+	 * The loop iterations left in the fuel slice of the interpreter.
+	 */
+    long budget;
+} HtmlLoopStack;
+
+/**
+ * Pushes the given loop onto the given stack, growing it when needed.
+ *
+ * @param context The context of the execution.
+ * @param stack The stack to push onto.
+ * @param loop The loop that is entered.
+ */
+static void html_push_loop(HtmlExecutionContext *context, HtmlLoopStack *stack, HtmlInstruction *loop)
+{
+    if (stack->depth == stack->size)
+    {
+        size_t size = stack->size ? stack->size * 2 : 16;
+        HtmlInstruction **loops = (HtmlInstruction **)realloc(stack->loops, size * sizeof(HtmlInstruction *));
+        if (loops == NULL)
+        {
+            context->status.instruction = loop;
+            html_fail(context, HTML_EXECUTION_OUT_OF_MEMORY);
+        }
+        stack->loops = loops;
+        stack->size = size;
+    }
+    stack->loops[stack->depth++] = loop;
+}
+
+/**
+ * Executes the given <code>HTML_INSTRUCTION_BALANCED_LOOP</code> until the
+ * 	current cell is zero, without checking the pointer moves in its body. The
+ * 	caller checks that the range of the loop lies on the tape, which covers
+ * 	every iteration since each of them starts on the same cell. The loops in
+ * 	the body are balanced as well and lie within that range.
+ *
+ * @param loop The loop to execute, the current cell must not be zero.
+ * @param context The context of the execution.
+ * @param stack The stack of the loops the interpreter is in.
+ * @return 1 if the loop ended, 0 if the program was stopped or ran out of fuel.
+ */
+static int html_execute_balanced(HtmlInstruction *loop, HtmlExecutionContext *context,
+                                 HtmlLoopStack *stack)
+{
+    unsigned char *tape = context->tape;
+    long index = context->tape_index;
+    size_t depth = stack->depth;
+    long budget = stack->budget;
+    HtmlInstruction *instruction = loop->loop;
+
+    html_push_loop(context, stack, loop);
+    for (;;)
+    {
+        if (instruction == NULL || instruction->type == HTML_TOKEN_LOOP_END)
+        {
+            if (tape[index])
+            {
+                if (--budget < 0 && (budget = html_fuel_refill(context) - 1) < 0)
+                {
+                    context->status.instruction = stack->loops[stack->depth - 1];
+                    break;
+                }
+                instruction = stack->loops[stack->depth - 1]->loop;
+            }
+            else if (--stack->depth == depth)
+                break;
+            else
+                instruction = stack->loops[stack->depth]->next;
+            continue;
+        }
+        switch (instruction->type)
+        {
+        case HTML_TOKEN_PLUS:
+            tape[index] += instruction->difference;
+            break;
+        case HTML_TOKEN_MINUS:
+            tape[index] -= instruction->difference;
+            break;
+        case HTML_INSTRUCTION_SET:
+            tape[index] = instruction->difference;
+            break;
+        case HTML_INSTRUCTION_MULTIPLY:
+            tape[index + instruction->offset] += (unsigned int)instruction->difference * tape[index];
+            break;
+        case HTML_TOKEN_NEXT:
+            index += instruction->difference;
+            break;
+        case HTML_TOKEN_PREVIOUS:
+            index -= instruction->difference;
+            break;
+        case HTML_TOKEN_OUTPUT:
+            context->tape_index = (int)index;
+            context->status.instruction = instruction;
+            html_output(context, tape[index], instruction->difference);
+            break;
+        case HTML_TOKEN_INPUT:
+            context->tape_index = (int)index;
+            context->status.instruction = instruction;
+            html_input(context, tape + index, instruction->difference);
+            break;
+        case HTML_INSTRUCTION_BALANCED_LOOP:
+            if (!tape[index])
+                break;
+            html_push_loop(context, stack, instruction);
+            instruction = instruction->loop;
+            continue;
+        case HTML_TOKEN_BREAK:
+            context->tape_index = (int)index;
+            context->status.instruction = instruction;
+            html_print_tape(context);
+            break;
+        }
+        instruction = instruction->next;
+    }
+    stack->depth = depth;
+    stack->budget = budget;
+    context->tape_index = (int)index;
+    return budget >= 0;
+}
+
+/**
+ * Interprets the given linked list of instructions on an array of bytes.
+ *
+ * @param root The start of the linked list of instructions.
+ * @param context The context of this execution.
+ * @param stack The stack of the loops the interpreter is in.
+ * @return Whether the execution ended before the end of the list.
+ */
+static int html_interpret(HtmlInstruction *root, HtmlExecutionContext *context, HtmlLoopStack *stack)
+{
+    HtmlInstruction *instruction = root;
+    int halted = 0;
+    stack->budget = html_fuel_refill(context);
+    for (;;)
+    {
+        if (instruction == NULL || instruction->type == HTML_TOKEN_LOOP_END)
+        {
+            /* End of the instruction list: take the back edge of the enclosing loop */
+            if (stack->depth == 0)
+                break;
+            if (context->tape[context->tape_index])
+            {
+                if (--stack->budget < 0 && (stack->budget = html_fuel_refill(context) - 1) < 0)
+                {
+                    context->status.instruction = stack->loops[stack->depth - 1];
+                    halted = 1;
+                    break;
+                }
+                instruction = stack->loops[stack->depth - 1]->loop;
+            }
+            else
+                instruction = stack->loops[--stack->depth]->next;
+            continue;
+        }
+        switch (instruction->type)
+        {
+        case HTML_TOKEN_PLUS:
+            context->tape[context->tape_index] += instruction->difference;
+            break;
+        case HTML_TOKEN_MINUS:
+            context->tape[context->tape_index] -= instruction->difference;
+            break;
+        case HTML_INSTRUCTION_SET:
+            context->tape[context->tape_index] = instruction->difference;
+            break;
+        case HTML_INSTRUCTION_SCAN:
+            context->status.instruction = instruction;
+            context->tape_index = (int)html_scan(context, context->tape_index, instruction->difference);
+            break;
+        case HTML_INSTRUCTION_MULTIPLY:
+            if (!context->tape[context->tape_index])
+                break;
+            if (((long)context->tape_index + instruction->offset >= (long)context->tape_size ||
+                 (long)context->tape_index + instruction->offset < -(long)context->tape_low) &&
+                !html_tape_extend(context, (long)context->tape_index + instruction->offset))
+            {
+                context->status.instruction = instruction;
+                if ((long)context->tape_index + instruction->offset < 0)
+                    html_tape_underrun(context);
+                html_tape_overrun(context);
+            }
+            context->tape[context->tape_index + instruction->offset] +=
+                (unsigned int)instruction->difference * context->tape[context->tape_index];
+            break;
+        case HTML_TOKEN_NEXT:
+            if ((unsigned long)instruction->difference >= INT_MAX - context->tape_size ||
+                ((long)context->tape_index + instruction->difference >= (long)context->tape_size &&
+                 !html_tape_extend(context, (long)context->tape_index + instruction->difference)))
+            {
+                context->status.instruction = instruction;
+                html_tape_overrun(context);
+            }
+            context->tape_index += instruction->difference;
+            break;
+        case HTML_TOKEN_PREVIOUS:
+            if ((unsigned long)instruction->difference >= INT_MAX - context->tape_size ||
+                ((long)context->tape_index - instruction->difference < -(long)context->tape_low &&
+                 !html_tape_extend(context, (long)context->tape_index - instruction->difference)))
+            {
+                context->status.instruction = instruction;
+                html_tape_underrun(context);
+            }
+            context->tape_index -= instruction->difference;
+            break;
+        case HTML_TOKEN_OUTPUT:
+            context->status.instruction = instruction;
+            html_output(context, context->tape[context->tape_index], instruction->difference);
+            break;
+        case HTML_TOKEN_INPUT:
+            context->status.instruction = instruction;
+            html_input(context, context->tape + context->tape_index, instruction->difference);
+            break;
+        case HTML_INSTRUCTION_BALANCED_LOOP:
+            /* One check of the whole range replaces the checks of every move in the loop */
+            if (context->tape[context->tape_index] &&
+                ((long)context->tape_index + instruction->offset >= -(long)context->tape_low ||
+                 html_tape_extend(context, (long)context->tape_index + instruction->offset)) &&
+                ((long)context->tape_index + instruction->difference < (long)context->tape_size ||
+                 html_tape_extend(context, (long)context->tape_index + instruction->difference)))
+            {
+                if (html_execute_balanced(instruction, context, stack))
+                    break;
+                halted = 1;
+                stack->depth = 0;
+                instruction = NULL;
+                continue;
+            }
+            /* The loop leaves the tape in some iteration, check every move to report where */
+            /* fall through */
+        case HTML_TOKEN_LOOP_START:
+            if (!context->tape[context->tape_index])
+                break;
+            html_push_loop(context, stack, instruction);
+            instruction = instruction->loop;
+            continue;
+        case HTML_TOKEN_BREAK:
+            context->status.instruction = instruction;
+            html_print_tape(context);
+            break;
+        default:
+            /* Unknown instructions end the current list */
+            instruction = NULL;
+            continue;
+        }
+        instruction = instruction->next;
+    }
+    html_fuel_return(context, stack->budget);
+    return halted;
+}
+
+/**
+ * Ends an execution that ran to its end, halted or failed: puts the status
+ * 	together and flushes the output.
+ *
+ * @param context The context of the execution.
+ * @param unwind Where errors unwound to before the execution.
+ * @param failed Whether the execution failed.
+ * @return How and where the execution ended.
+ */
+static HtmlStatus html_finish(HtmlExecutionContext *context, void *unwind, int failed)
+{
+    context->unwind = unwind;
+    if (failed)
+    {
+        /* The engine was left in the middle of a slice and cannot continue */
+        context->fuel_slice = 0;
+        context->resume_program = 0;
+    }
+    if (html_output_flush(context) < 0 && context->status.code < HTML_EXECUTION_OVERRUN)
+        context->status.code = HTML_EXECUTION_IO_ERROR;
+    context->status.tape_index = context->tape_index;
+    return context->status;
+}
+
+/**
+ * Executes the given linked list containing instructions. On sparse tapes and
+ * 	tapes of wider cells they are compiled into a temporary program, which
+ * 	cannot be resumed once it is stopped or runs out of fuel.
+ * 
+ * @param root The start of the linked list of instructions you want
+ * 	to execute.
+ * @param context The context of this execution that contains the tape and
+ *	other execution related variables.
+ * @return How and where the execution ended.
+ */
+HtmlStatus html_execute(HtmlInstruction *root, HtmlExecutionContext *context)
+{
+    HtmlStatus status = {HTML_EXECUTION_DONE, HTML_POSITION_UNKNOWN, NULL, 0};
+    if (root == NULL || context == NULL)
+        return status;
+    if (context->tape_pages != NULL || context->cell_size != 1)
+    {
+        /* The interpreter indexes an array of bytes, so programs on other tapes are compiled */
+        HtmlProgram *program = html_compile(root);
+        if (program == NULL)
+        {
+            status.code = HTML_EXECUTION_OUT_OF_MEMORY;
+            status.tape_index = context->tape_index;
+            return context->status = status;
+        }
+        status = html_execute_program(program, context);
+        /* The program is gone, so it cannot be resumed */
+        context->resume_program = 0;
+        html_destroy_program(program);
+        return status;
+    }
+    HtmlUnwind unwind;
+    void *previous = context->unwind;
+    /* The loops we are currently in, innermost last */
+    HtmlLoopStack stack = {0, 0, 0, 0};
+    int failed = 1;
+    context->status = status;
+    context->unwind = &unwind;
+    if (HTML_UNWIND_SET(unwind) == 0)
+    {
+        context->status.code = html_execution_status(context, html_interpret(root, context, &stack));
+        if (context->status.code == HTML_EXECUTION_DONE)
+            context->status.instruction = NULL;
+        failed = 0;
+    }
+    free(stack.loops);
+    return html_finish(context, previous, failed);
+}
+
+/**
+ * The state of the compiler while it turns instructions into operations.
+ */
+typedef struct HtmlCompiler
+{
+    /**
+	 * The program that is being compiled.
+	 */
+    HtmlProgram *program;
+    /**
+	 * The number of operations the operation array of the program can hold.
+	 */
+    size_t capacity;
+    /**
+	 * The index of the first operation of the current basic block.
+	 */
+    size_t block;
+    /**
+	 * The distance between the tape pointer at runtime and the cell the
+	 * 	compiled code has moved to since the start of the current block.
+	 */
+    int shift;
+    /**
+	 * The lowest and highest offset accessed in the current block.
+	 */
+    int low, high;
+    /**
+	 * The direction of the last move if no cell was accessed after it, otherwise
+	 * 	<code>0</code>.
+	 */
+    int direction;
+} HtmlCompiler;
+
+/**
+ * Appends an operation to the program that is being compiled, growing the
+ * 	operation array when needed.
+ *
+ * @param compiler The compiler.
+ * @param type The type of the operation.
+ * @param difference The difference of the operation.
+ * @param offset The offset of the cell the operation operates on.
+ * @return The index of the new operation or <code>-1</code> on allocation failure.
+ */
+static long html_emit(HtmlCompiler *compiler, unsigned char type, int difference, int offset)
+{
+    HtmlProgram *program = compiler->program;
+    if (program->length == compiler->capacity)
+    {
+        size_t size = compiler->capacity ? compiler->capacity * 2 : 64;
+        HtmlOp *ops = (HtmlOp *)realloc(program->ops, size * sizeof(HtmlOp));
+        if (ops == NULL)
+            return -1;
+        program->ops = ops;
+        compiler->capacity = size;
+    }
+    program->ops[program->length].type = type;
+    program->ops[program->length].difference = difference;
+    program->ops[program->length].jump = 0;
+    program->ops[program->length].offset = offset;
+    return (long)program->length++;
+}
+
+/**
+ * Appends an operation that accesses the cell at the current shift to the
+ * 	current block.
+ *
+ * @param compiler The compiler.
+ * @param type The type of the operation.
+ * @param difference The difference of the operation.
+ * @return The index of the new operation or <code>-1</code> on allocation failure.
+ */
+static long html_emit_access(HtmlCompiler *compiler, unsigned char type, int difference)
+{
+    if (compiler->shift < compiler->low)
+        compiler->low = compiler->shift;
+    if (compiler->shift > compiler->high)
+        compiler->high = compiler->shift;
+    compiler->direction = 0;
+    return html_emit(compiler, type, difference, compiler->shift);
+}
+
+/**
+ * Records a pointer move in the current block instead of emitting it.
+ *
+ * @param compiler The compiler.
+ * @param difference The number of cells to move, negative to the left.
+ * @return <code>0</code> or <code>-1</code> on allocation failure.
+ */
+static long html_move(HtmlCompiler *compiler, int difference)
+{
+    int direction = difference > 0 ? 1 : -1;
+    if (difference == 0)
+        return 0;
+    /* The pointer turns around on a cell nothing accesses, which must be checked
+     * 	as well. Moves in one direction only need their destination checked. */
+    if (compiler->direction == -direction &&
+        html_emit_access(compiler, HTML_OP_ADD, 0) < 0)
+        return -1;
+    compiler->shift += difference;
+    compiler->direction = direction;
+    return 0;
+}
+
+/**
+ * Ends the current basic block: inserts a single check of all cells the block
+ * 	accesses in front of it and applies the accumulated pointer movement.
+ *
+ * @param compiler The compiler.
+ * @return <code>0</code> or <code>-1</code> on allocation failure.
+ */
+static long html_flush(HtmlCompiler *compiler)
+{
+    HtmlProgram *program = compiler->program;
+    if (compiler->low < 0 || compiler->high > 0)
+    {
+        if (html_emit(compiler, HTML_OP_CHECK, 0, 0) < 0)
+            return -1;
+        memmove(program->ops + compiler->block + 1, program->ops + compiler->block,
+                (program->length - 1 - compiler->block) * sizeof(HtmlOp));
+        program->ops[compiler->block].type = HTML_OP_CHECK;
+        program->ops[compiler->block].offset = compiler->low;
+        program->ops[compiler->block].difference = compiler->high;
+        program->ops[compiler->block].jump = 0;
+    }
+    if (compiler->shift != 0 && html_emit(compiler, HTML_OP_MOVE, compiler->shift, 0) < 0)
+        return -1;
+    compiler->shift = compiler->low = compiler->high = compiler->direction = 0;
+    compiler->block = program->length;
+    return 0;
+}
+
+/**
+ * Stores the largest distance between the tape pointer and a cell the
+ * 	operations of the given program move to or access in its reach. Checks
+ * 	cover the cells of their block and moves the cells in between blocks.
+ *
+ * @param program The program to measure.
+ */
+static void html_measure_reach(HtmlProgram *program)
+{
+    const HtmlOp *op;
+    long low, high;
+    for (op = program->ops; op < program->ops + program->length; op++)
+    {
+        switch (op->type)
+        {
+        case HTML_OP_CHECK:
+            low = op->offset;
+            high = op->difference;
+            break;
+        case HTML_OP_MOVE:
+            low = high = op->difference;
+            break;
+        case HTML_OP_MULTIPLY:
+            low = high = op->offset;
+            break;
+        default:
+            continue;
+        }
+        if (-low > program->reach)
+            program->reach = -low;
+        if (high > program->reach)
+            program->reach = high;
+    }
+}
+
+/* The serial number of the program compiled last */
+static unsigned long html_serial;
+#ifdef HTML_HAVE_PTHREADS
+static pthread_mutex_t html_serial_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * Compiles the given linked list containing instructions into a program.
+ * 	Compilation stops at the same point <code>html_execute</code> would.
+ *
+ * Pointer moves are not compiled into operations of their own. Within a basic
+ * 	block, every operation addresses its cell relative to the pointer at the
+ * 	start of the block, the whole range of addressed cells is checked once at
+ * 	the start of the block and the pointer is moved once at its end.
+ *
+ * When built with the JIT, the machine code of the program is generated here
+ * 	as well, so executions only read it. A program whose machine code could
+ * 	not be generated runs on the checked engines instead.
+ *
+ * @param root The start of the linked list of instructions you want
+ * 	to compile.
+ * @return The compiled program or <code>NULL</code> if it could not be allocated.
+ */
+HtmlProgram *html_compile(HtmlInstruction *root)
+{
+    HtmlProgram *program = (HtmlProgram *)malloc(sizeof(HtmlProgram));
+    if (program == NULL)
+        return NULL;
+    program->ops = 0;
+    program->length = 0;
+    program->code = 0;
+    program->code_size = 0;
+    program->code_offsets = 0;
+    program->reach = 0;
+#ifdef HTML_HAVE_PTHREADS
+    pthread_mutex_lock(&html_serial_lock);
+#endif
+    program->serial = ++html_serial;
+#ifdef HTML_HAVE_PTHREADS
+    pthread_mutex_unlock(&html_serial_lock);
+#endif
+
+    HtmlCompiler compiler;
+    compiler.program = program;
+    compiler.capacity = 0;
+    compiler.block = 0;
+    compiler.shift = compiler.low = compiler.high = compiler.direction = 0;
+
+    /* The loop instructions we descended into, with the index of their operation */
+    HtmlInstruction **loops = 0;
+    long *starts = 0;
+    size_t depth = 0, loops_size = 0;
+    HtmlInstruction *instruction = root;
+    long index = 0;
+
+    while (index >= 0)
+    {
+        if (instruction == NULL || instruction->type == HTML_TOKEN_LOOP_END)
+        {
+            if (depth == 0)
+                break;
+            depth--;
+            if (html_flush(&compiler) < 0 ||
+                (index = html_emit(&compiler, HTML_OP_LOOP_END, 0, 0)) < 0)
+                break;
+            compiler.block = program->length;
+            program->ops[index].jump = (int)starts[depth];
+            program->ops[starts[depth]].jump = (int)index;
+            instruction = loops[depth]->next;
+            continue;
+        }
+        switch (instruction->type)
+        {
+        case HTML_TOKEN_PLUS:
+            index = html_emit_access(&compiler, HTML_OP_ADD, instruction->difference);
+            break;
+        case HTML_TOKEN_MINUS:
+            index = html_emit_access(&compiler, HTML_OP_ADD, -instruction->difference);
+            break;
+        case HTML_INSTRUCTION_SET:
+            index = html_emit_access(&compiler, HTML_OP_SET, instruction->difference);
+            break;
+        case HTML_TOKEN_OUTPUT:
+            index = html_emit_access(&compiler, HTML_OP_OUTPUT, instruction->difference);
+            break;
+        case HTML_TOKEN_INPUT:
+            index = html_emit_access(&compiler, HTML_OP_INPUT, instruction->difference);
+            break;
+        case HTML_TOKEN_NEXT:
+            index = html_move(&compiler, instruction->difference);
+            break;
+        case HTML_TOKEN_PREVIOUS:
+            index = html_move(&compiler, -instruction->difference);
+            break;
+        case HTML_INSTRUCTION_SCAN:
+            if ((index = html_flush(&compiler)) >= 0)
+                index = html_emit(&compiler, HTML_OP_SCAN, instruction->difference, 0);
+            compiler.block = program->length;
+            break;
+        case HTML_INSTRUCTION_MULTIPLY:
+            if ((index = html_flush(&compiler)) >= 0)
+                index = html_emit(&compiler, HTML_OP_MULTIPLY, instruction->difference,
+                                  instruction->offset);
+            compiler.block = program->length;
+            break;
+        case HTML_TOKEN_BREAK:
+            if ((index = html_flush(&compiler)) >= 0)
+                index = html_emit(&compiler, HTML_OP_BREAK, 0, 0);
+            compiler.block = program->length;
+            break;
+        case HTML_TOKEN_LOOP_START:
+        case HTML_INSTRUCTION_BALANCED_LOOP:
+            if (html_flush(&compiler) < 0 ||
+                (index = html_emit(&compiler, HTML_OP_LOOP_START, 0, 0)) < 0)
+            {
+                index = -1;
+                break;
+            }
+            compiler.block = program->length;
+            if (depth == loops_size)
+            {
+                size_t size = loops_size ? loops_size * 2 : 16;
+                HtmlInstruction **new_loops = (HtmlInstruction **)
+                    realloc(loops, size * sizeof(HtmlInstruction *));
+                long *new_starts = new_loops == NULL ? NULL : (long *)realloc(starts, size * sizeof(long));
+                if (new_loops != NULL)
+                    loops = new_loops;
+                if (new_starts == NULL)
+                {
+                    index = -1;
+                    break;
+                }
+                starts = new_starts;
+                loops_size = size;
+            }
+            loops[depth] = instruction;
+            starts[depth] = index;
+            depth++;
+            instruction = instruction->loop;
+            continue;
+        default:
+            /* Unknown instructions end the current list, like in html_execute */
+            instruction = NULL;
+            continue;
+        }
+        instruction = instruction->next;
+    }
+    free(loops);
+    free(starts);
+
+    if (index < 0 || html_flush(&compiler) < 0 || html_emit(&compiler, HTML_OP_END, 0, 0) < 0)
+    {
+        html_destroy_program(program);
+        return NULL;
+    }
+    html_measure_reach(program);
+#ifdef HTML_HAVE_JIT
+    html_jit_compile(program);
+#endif
+    return program;
+}
+
+/**
+ * An engine that executes a compiled program on the tape of a context.
+ */
+typedef void (*HtmlEngine)(const HtmlProgram *program, HtmlExecutionContext *context);
+
+/* The engines for each cell size, see html_engines.h for the order of the tables */
+#define HTML_ENGINES_CELL unsigned char
+#define HTML_ENGINES_SUFFIX 8
+#include "html_engines.h"
+
+#define HTML_ENGINES_CELL unsigned short
+#define HTML_ENGINES_SUFFIX 16
+#include "html_engines.h"
+
+#define HTML_ENGINES_CELL unsigned int
+#define HTML_ENGINES_SUFFIX 32
+#include "html_engines.h"
+
+#define HTML_ENGINES_CHECKED 0
+#define HTML_ENGINES_UNCHECKED 2
+#define HTML_ENGINES_SPARSE 4
+
+/**
+ * Selects the engine variant for the cells of the given context and the
+ * 	dispatch it selects.
+ *
+ * @param context The context of the execution.
+ * @param kind One of the <code>HTML_ENGINES_*</code> kinds of tape access.
+ * @return The engine.
+ */
+static HtmlEngine html_engine(const HtmlExecutionContext *context, int kind)
+{
+    const HtmlEngine *engines = context->cell_size == 4   ? html_engines_32
+                                : context->cell_size == 2 ? html_engines_16
+                                                          : html_engines_8;
+    return engines[kind + (context->engine != HTML_ENGINE_SWITCH)];
+}
+
+#ifdef HTML_HAVE_GUARD
+
+/* The context whose guarded tape the current thread executes a program on */
+static __thread HtmlExecutionContext *html_guarded_context;
+/* The SIGSEGV action that was installed before html_guard_fault */
+static struct sigaction html_guard_previous;
+static volatile sig_atomic_t html_guard_installed;
+#ifdef HTML_HAVE_PTHREADS
+/* Keeps threads that start guarded executions at once from installing the handler twice */
+static pthread_mutex_t html_guard_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * Handles a fault of the running program: an access to the part of a guarded
+ * 	tape that is not committed yet commits it and is retried, an access to a
+ * 	guard region is reported like the checks of the other engines report it.
+ * 	Other faults are passed on to the action installed before.
+ *
+ * @param signal The signal number.
+ * @param info The information about the fault.
+ * @param ucontext The interrupted machine context.
+ */
+static void html_guard_fault(int signal, siginfo_t *info, void *ucontext)
+{
+    HtmlExecutionContext *context = html_guarded_context;
+    unsigned char *address = (unsigned char *)info->si_addr;
+
+    if (context != NULL &&
+        address >= context->tape - html_tape_start(context->tape_limit, context->tape_options, context->cell_size) &&
+        address < context->tape - html_tape_start(context->tape_limit, context->tape_options, context->cell_size) +
+                      html_tape_mapping(context->tape_limit, context->tape_options, context->cell_size))
+    {
+        long offset = (long)(address - context->tape);
+        /* Round down to the cell the faulting byte belongs to, before cell 0 as well */
+        long cell = offset >= 0 ? offset / context->cell_size
+                                : -((-offset + context->cell_size - 1) / context->cell_size);
+        if (html_tape_extend(context, cell))
+            return;
+        /* The engine keeps its tape index and position in registers */
+        context->tape_index = (int)cell;
+        context->status.position = HTML_POSITION_UNKNOWN;
+        if (cell < 0)
+            html_tape_underrun(context);
+        html_tape_overrun(context);
+    }
+    /* The fault happens again when the handler returns, now with the previous action */
+    sigaction(SIGSEGV, &html_guard_previous, NULL);
+    html_guard_installed = 0;
+    (void)signal;
+    (void)ucontext;
+}
+
+/**
+ * Installs the SIGSEGV handler of guarded tapes when an execution on one
+ * 	starts, unless it is installed already.
+ */
+static void html_guard_install(void)
+{
+    struct sigaction action;
+#ifdef HTML_HAVE_PTHREADS
+    pthread_mutex_lock(&html_guard_lock);
+#endif
+    if (!html_guard_installed)
+    {
+        memset(&action, 0, sizeof(struct sigaction));
+        action.sa_sigaction = &html_guard_fault;
+        action.sa_flags = SA_SIGINFO | SA_NODEFER;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGSEGV, &action, &html_guard_previous) == 0)
+            html_guard_installed = 1;
+    }
+#ifdef HTML_HAVE_PTHREADS
+    pthread_mutex_unlock(&html_guard_lock);
+#endif
 }
 
 /**
- * Destroys the given instruction.
- * 
- * @param instruction The instruction to destroy.
+ * Executes the given program on the guarded tape of the given context without
+ * 	checking the tape bounds, which the guard regions do instead.
+ *
+ * @param program The program to execute.
+ * @param context The context of this execution.
  */
-void html_destroy_instruction(HtmlInstruction *instruction)
+static void html_execute_guarded(const HtmlProgram *program, HtmlExecutionContext *context)
 {
-    if (instruction == NULL)
-        return;
-    free(instruction);
-    instruction = 0;
+    html_guard_install();
+    html_guarded_context = context;
+    html_engine(context, HTML_ENGINES_UNCHECKED)(program, context);
+    html_guarded_context = 0;
+    /* A final move off the tape is not followed by an access that faults */
+    if (!html_tape_extend(context, context->tape_index))
+    {
+        if (context->tape_index < 0)
+            html_tape_underrun(context);
+        html_tape_overrun(context);
+    }
 }
+#endif
+
+#ifdef HTML_HAVE_JIT
+/* Labels the JIT resolves after the operations, relative to the program length */
+#define HTML_JIT_EXIT 0
+#define HTML_JIT_OVERRUN 1
+#define HTML_JIT_UNDERRUN 2
+/* The slow paths of the operations follow the labels above, one per operation */
+#define HTML_JIT_SLOW 3
 
 /**
- * Destroys a linked list containing instructions.
- * 
- * @param root The start of the instruction list.
+ * The state of the JIT while it generates the machine code of a program.
  */
-void html_destroy_instructions(HtmlInstruction *root)
+typedef struct HtmlJit
 {
-    HtmlInstruction *tmp;
-    while (root != NULL)
+    unsigned char *code;
+    size_t length;
+    size_t capacity;
+    /* The code offset of every operation, followed by the labels above */
+    size_t *labels;
+    /* Pairs of the code offset of a 32-bit jump displacement and its label */
+    size_t *fixups;
+    size_t fixups_length;
+    size_t fixups_capacity;
+    int failed;
+} HtmlJit;
+
+/**
+ * Appends the given bytes to the generated code.
+ *
+ * @param jit The JIT to append the bytes to.
+ * @param bytes The bytes to append.
+ * @param count The number of bytes to append.
+ */
+static void html_jit_emit(HtmlJit *jit, const char *bytes, size_t count)
+{
+    if (jit->length + count > jit->capacity)
     {
-        tmp = root;
-        html_destroy_instructions(root->loop);
-        root = root->next;
-        html_destroy_instruction(tmp);
+        size_t capacity = jit->capacity ? jit->capacity * 2 : 4096;
+        unsigned char *code = (unsigned char *)realloc(jit->code, capacity);
+        if (code == NULL)
+        {
+            jit->failed = 1;
+            return;
+        }
+        jit->code = code;
+        jit->capacity = capacity;
     }
+    memcpy(jit->code + jit->length, bytes, count);
+    jit->length += count;
 }
 
 /**
- * Destroys a state.
- * 
- * @param state The state to destroy
+ * Appends a little-endian integer to the generated code.
+ *
+ * @param jit The JIT to append the integer to.
+ * @param value The value of the integer.
+ * @param count The size of the integer in bytes.
  */
-void html_destroy_state(HtmlState *state)
+static void html_jit_integer(HtmlJit *jit, unsigned long value, size_t count)
 {
-    if (state == NULL)
-        return;
-    html_destroy_instructions(state->root);
-    state->head = 0;
-    state->root = 0;
-    free(state);
-    state = 0;
+    char bytes[8];
+    size_t i;
+    for (i = 0; i < count; i++)
+        bytes[i] = (char)(value >> (8 * i));
+    html_jit_emit(jit, bytes, count);
 }
 
 /**
- * Destroys a context.
- * 
- * @param context The context to destroy
+ * Appends a jump instruction with a 32-bit displacement to a label that is
+ * 	resolved once all code has been generated.
+ *
+ * @param jit The JIT to append the jump to.
+ * @param opcode The opcode of the jump instruction.
+ * @param count The size of the opcode in bytes.
+ * @param label The index of the operation or label to jump to.
  */
-void html_destroy_context(HtmlExecutionContext *context)
+static void html_jit_jump(HtmlJit *jit, const char *opcode, size_t count, size_t label)
 {
-    free(context->tape);
-    free(context);
-    context = 0;
+    html_jit_emit(jit, opcode, count);
+    if (jit->fixups_length + 2 > jit->fixups_capacity)
+    {
+        size_t capacity = jit->fixups_capacity ? jit->fixups_capacity * 2 : 256;
+        size_t *fixups = (size_t *)realloc(jit->fixups, capacity * sizeof(size_t));
+        if (fixups == NULL)
+        {
+            jit->failed = 1;
+            return;
+        }
+        jit->fixups = fixups;
+        jit->fixups_capacity = capacity;
+    }
+    jit->fixups[jit->fixups_length++] = jit->length;
+    jit->fixups[jit->fixups_length++] = label;
+    html_jit_integer(jit, 0, 4);
 }
 
 /**
- * Executes the given linked list containing instructions.
- * 
- * @param root The start of the linked list of instructions you want
- * 	to execute.
- * @param context The context of this execution that contains the tape and
- *	other execution related variables.
+ * Appends a call of the given function, with the execution context as its
+ * 	first argument and optionally the current tape index as its second.
+ *
+ * @param jit The JIT to append the call to.
+ * @param function The address of the function to call.
+ * @param index Whether to pass the current tape index.
  */
-void html_execute(HtmlInstruction *root, HtmlExecutionContext *context)
+static void html_jit_call(HtmlJit *jit, unsigned long function, int index)
 {
-    if (root == NULL || context == NULL)
-        return;
-    HtmlInstruction *instruction = root;
-    int index;
-    while (instruction != NULL && instruction->type != HTML_TOKEN_LOOP_END)
+    /* mov rdi, r12 */
+    html_jit_emit(jit, "\x4c\x89\xe7", 3);
+    /* mov rsi, rbx; sub rsi, r13 */
+    if (index)
+        html_jit_emit(jit, "\x48\x89\xde\x4c\x29\xee", 6);
+    /* mov rax, function; call rax */
+    html_jit_emit(jit, "\x48\xb8", 2);
+    html_jit_integer(jit, function, 8);
+    html_jit_emit(jit, "\xff\xd0", 2);
+}
+
+/**
+ * Appends the loads of the committed bounds of the tape from the context,
+ * 	which change when the tape grows.
+ *
+ * @param jit The JIT to append the loads to.
+ */
+static void html_jit_bounds(HtmlJit *jit)
+{
+    /* mov r14, [r12 + tape_size]; add r14, r13 */
+    html_jit_emit(jit, "\x4d\x8b\xb4\x24", 4);
+    html_jit_integer(jit, offsetof(HtmlExecutionContext, tape_size), 4);
+    html_jit_emit(jit, "\x4d\x01\xee", 3);
+    /* mov r15, [r12 + tape_low]; neg r15; add r15, r13 */
+    html_jit_emit(jit, "\x4d\x8b\xbc\x24", 4);
+    html_jit_integer(jit, offsetof(HtmlExecutionContext, tape_low), 4);
+    html_jit_emit(jit, "\x49\xf7\xdf\x4d\x01\xef", 6);
+}
+
+/**
+ * Appends the stores of the given operation index and of the current tape
+ * 	index into the context, which the status of an error reports.
+ *
+ * @param jit The JIT to append the stores to.
+ * @param position The index of the operation.
+ */
+static void html_jit_at(HtmlJit *jit, size_t position)
+{
+    /* mov qword [r12 + status.position], position */
+    html_jit_emit(jit, "\x49\xc7\x84\x24", 4);
+    html_jit_integer(jit, offsetof(HtmlExecutionContext, status) + offsetof(HtmlStatus, position), 4);
+    html_jit_integer(jit, (unsigned long)position, 4);
+    /* mov rax, rbx; sub rax, r13; mov [r12 + tape_index], eax */
+    html_jit_emit(jit, "\x48\x89\xd8\x4c\x29\xe8\x41\x89\x84\x24", 10);
+    html_jit_integer(jit, offsetof(HtmlExecutionContext, tape_index), 4);
+}
+
+/**
+ * Reports a tape overrun from generated code.
+ *
+ * @param context The context of the execution.
+ * @param index The tape index at the operation that overran the tape.
+ */
+static void html_jit_overrun(HtmlExecutionContext *context, long index)
+{
+    context->tape_index = (int)index;
+    html_tape_overrun(context);
+}
+
+/**
+ * Reports a tape underrun from generated code.
+ *
+ * @param context The context of the execution.
+ * @param index The tape index at the operation that underran the tape.
+ */
+static void html_jit_underrun(HtmlExecutionContext *context, long index)
+{
+    context->tape_index = (int)index;
+    html_tape_underrun(context);
+}
+
+/**
+ * Prints the tape for the <code>HTML_OP_BREAK</code> operation from generated
+ * 	code.
+ *
+ * @param context The context of the execution.
+ * @param index The current tape index.
+ */
+static void html_jit_break(HtmlExecutionContext *context, long index)
+{
+    context->tape_index = (int)index;
+    html_print_tape(context);
+}
+
+/**
+ * Records where generated code stopped for a lack of fuel or a stop request.
+ *
+ * @param context The context of the execution.
+ * @param index The current tape index.
+ * @param position The operation to continue at.
+ * @param program The program that stopped.
+ */
+static void html_jit_halt(HtmlExecutionContext *context, long index, long position,
+                          const HtmlProgram *program)
+{
+    context->tape_index = (int)index;
+    context->status.position = (size_t)position;
+    html_halt(context, program, (size_t)position);
+}
+
+/**
+ * Generates the x86-64 machine code of the given program and maps it into
+ * 	executable memory.
+ *
+ * The generated function follows the System V calling convention and has the
+ * 	signature <code>long (HtmlExecutionContext *, unsigned char *tape,
+ * 	long index, void *resume)</code>, returning the tape index it stopped at.
+ * 	It starts at the address <code>resume</code> in its code unless that is
+ * 	<code>NULL</code>. While it runs, rbx points to the current cell, r12 holds
+ * 	the context, r13 points to cell 0, r15 and r14 to the start and the end of
+ * 	the committed tape, and rbp counts down the loop iterations left in the
+ * 	fuel slice. Input, output, scans and errors are handled by calling back
+ * 	into the functions the interpreters use.
+ *
+ * @param program The program to generate the machine code of.
+ * @return 0 if <code>program->code</code> was set, -1 otherwise.
+ */
+static int html_jit_compile(HtmlProgram *program)
+{
+    HtmlJit jit;
+    const HtmlOp *op;
+    size_t i;
+    void *code;
+
+    memset(&jit, 0, sizeof(HtmlJit));
+    jit.labels = (size_t *)malloc((2 * program->length + HTML_JIT_SLOW) * sizeof(size_t));
+    if (jit.labels == NULL)
+        return -1;
+
+    /* push rbx; push rbp; push r12; push r13; push r14; push r15; sub rsp, 8 (aligns the stack) */
+    html_jit_emit(&jit, "\x53\x55\x41\x54\x41\x55\x41\x56\x41\x57\x48\x83\xec\x08", 14);
+    /* mov r12, rdi; mov r13, rsi; lea rbx, [rsi + rdx]; mov [rsp], rcx */
+    html_jit_emit(&jit, "\x49\x89\xfc\x49\x89\xf5\x48\x8d\x1c\x16\x48\x89\x0c\x24", 14);
+    html_jit_bounds(&jit);
+    /* rbp = html_fuel_refill(context) */
+    html_jit_call(&jit, (unsigned long)&html_fuel_refill, 0);
+    html_jit_emit(&jit, "\x48\x89\xc5", 3);
+    /* mov rax, [rsp]; test rax, rax; jz start; jmp rax */
+    html_jit_emit(&jit, "\x48\x8b\x04\x24", 4);
+    html_jit_jump(&jit, "\x48\x85\xc0\x0f\x84", 5, 0);
+    html_jit_emit(&jit, "\xff\xe0", 2);
+
+    for (i = 0; i < program->length; i++)
     {
-        switch (instruction->type)
+        op = program->ops + i;
+        jit.labels[i] = jit.length;
+        switch (op->type)
         {
-        case HTML_TOKEN_PLUS:
-            context->tape[context->tape_index] += instruction->difference;
+        case HTML_OP_ADD:
+        case HTML_OP_SET:
+            /* add byte [rbx + offset], difference or mov byte [rbx + offset], difference */
+            html_jit_emit(&jit, op->type == HTML_OP_ADD ? "\x80\x83" : "\xc6\x83", 2);
+            html_jit_integer(&jit, (unsigned long)op->offset, 4);
+            html_jit_integer(&jit, (unsigned long)op->difference, 1);
             break;
-        case HTML_TOKEN_MINUS:
-            context->tape[context->tape_index] -= instruction->difference;
+        case HTML_OP_CHECK:
+            /* lea rax, [rbx + low]; cmp rax, r15; jb slow */
+            html_jit_emit(&jit, "\x48\x8d\x83", 3);
+            html_jit_integer(&jit, (unsigned long)op->offset, 4);
+            html_jit_jump(&jit, "\x4c\x39\xf8\x0f\x82", 5, program->length + HTML_JIT_SLOW + i);
+            /* lea rax, [rbx + high]; cmp rax, r14; jae slow */
+            html_jit_emit(&jit, "\x48\x8d\x83", 3);
+            html_jit_integer(&jit, (unsigned long)op->difference, 4);
+            html_jit_jump(&jit, "\x4c\x39\xf0\x0f\x83", 5, program->length + HTML_JIT_SLOW + i);
             break;
-        case HTML_TOKEN_NEXT:
-            if ((unsigned long)instruction->difference >= INT_MAX - context->tape_size ||
-                (unsigned long)context->tape_index + instruction->difference >= context->tape_size)
-            {
-                fprintf(stderr, "error: tape memory out of bounds (overrun)\nexceeded the tape size of %zd cells\n", context->tape_size);
-                exit(EXIT_FAILURE);
-            }
-            context->tape_index += instruction->difference;
+        case HTML_OP_MULTIPLY:
+            /* movzx eax, byte [rbx]; test eax, eax; jz next */
+            html_jit_emit(&jit, "\x0f\xb6\x03\x85\xc0\x74\x21", 7);
+            /* lea rcx, [rbx + offset]; cmp rcx, r14; jae slow; cmp rcx, r15; jb slow */
+            html_jit_emit(&jit, "\x48\x8d\x8b", 3);
+            html_jit_integer(&jit, (unsigned long)op->offset, 4);
+            html_jit_jump(&jit, "\x4c\x39\xf1\x0f\x83", 5, program->length + HTML_JIT_SLOW + i);
+            html_jit_jump(&jit, "\x4c\x39\xf9\x0f\x82", 5, program->length + HTML_JIT_SLOW + i);
+            /* imul eax, eax, factor; add byte [rcx], al */
+            html_jit_emit(&jit, "\x69\xc0", 2);
+            html_jit_integer(&jit, (unsigned long)op->difference, 4);
+            html_jit_emit(&jit, "\x00\x01", 2);
             break;
-        case HTML_TOKEN_PREVIOUS:
-            if ((unsigned long)instruction->difference >= INT_MAX - context->tape_size ||
-                context->tape_index - instruction->difference < 0)
-            {
-                fprintf(stderr, "error: tape memory out of bounds (underrun)\nundershot the tape size of %zd cells\n", context->tape_size);
-                exit(EXIT_FAILURE);
-            }
-            context->tape_index -= instruction->difference;
+        case HTML_OP_SCAN:
+            html_jit_at(&jit, i);
+            /* rax = html_scan(context, index, stride); lea rbx, [r13 + rax] */
+            html_jit_emit(&jit, "\xba", 1);
+            html_jit_integer(&jit, (unsigned long)op->difference, 4);
+            html_jit_call(&jit, (unsigned long)&html_scan, 1);
+            html_jit_emit(&jit, "\x49\x8d\x5c\x05\x00", 5);
             break;
-        case HTML_TOKEN_OUTPUT:
-            for (index = 0; index < instruction->difference; index++)
-                context->output_handler(context->tape[context->tape_index]);
+        case HTML_OP_MOVE:
+            /* lea rax, [rbx + difference]; cmp rax, r14; jae slow; cmp rax, r15; jb slow */
+            html_jit_emit(&jit, "\x48\x8d\x83", 3);
+            html_jit_integer(&jit, (unsigned long)op->difference, 4);
+            html_jit_jump(&jit, "\x4c\x39\xf0\x0f\x83", 5, program->length + HTML_JIT_SLOW + i);
+            html_jit_jump(&jit, "\x4c\x39\xf8\x0f\x82", 5, program->length + HTML_JIT_SLOW + i);
+            /* mov rbx, rax */
+            html_jit_emit(&jit, "\x48\x89\xc3", 3);
             break;
-        case HTML_TOKEN_INPUT:
-            for (index = 0; index < instruction->difference; index++)
-            {
-                char input = context->input_handler();
-                if (input == EOF)
-                {
-                    if (HTML_EOF_BEHAVIOR != 1)
-                        context->tape[context->tape_index] = HTML_EOF_BEHAVIOR;
-                }
-                else
-                {
-                    context->tape[context->tape_index] = input;
-                }
-            }
+        case HTML_OP_OUTPUT:
+            html_jit_at(&jit, i);
+            /* movzx esi, byte [rbx + offset]; mov edx, count */
+            html_jit_emit(&jit, "\x0f\xb6\xb3", 3);
+            html_jit_integer(&jit, (unsigned long)op->offset, 4);
+            html_jit_emit(&jit, "\xba", 1);
+            html_jit_integer(&jit, (unsigned long)op->difference, 4);
+            html_jit_call(&jit, (unsigned long)&html_output, 0);
             break;
-        case HTML_TOKEN_LOOP_START:
-            while (context->tape[context->tape_index])
-                html_execute(instruction->loop, context);
+        case HTML_OP_INPUT:
+            html_jit_at(&jit, i);
+            /* lea rsi, [rbx + offset]; mov edx, count */
+            html_jit_emit(&jit, "\x48\x8d\xb3", 3);
+            html_jit_integer(&jit, (unsigned long)op->offset, 4);
+            html_jit_emit(&jit, "\xba", 1);
+            html_jit_integer(&jit, (unsigned long)op->difference, 4);
+            html_jit_call(&jit, (unsigned long)&html_input, 0);
             break;
-        case HTML_TOKEN_BREAK:
+        case HTML_OP_LOOP_START:
+            /* cmp byte [rbx], 0; je after the loop */
+            html_jit_jump(&jit, "\x80\x3b\x00\x0f\x84", 5, (size_t)op->jump + 1);
+            break;
+        case HTML_OP_LOOP_END:
+            /* cmp byte [rbx], 0; je after the loop */
+            html_jit_jump(&jit, "\x80\x3b\x00\x0f\x84", 5, i + 1);
+            /* sub rbp, 1; jns the start of the loop body; jmp slow */
+            html_jit_jump(&jit, "\x48\x83\xed\x01\x0f\x89", 6, (size_t)op->jump + 1);
+            html_jit_jump(&jit, "\xe9", 1, program->length + HTML_JIT_SLOW + i);
+            break;
+        case HTML_OP_BREAK:
+            html_jit_at(&jit, i);
+            html_jit_call(&jit, (unsigned long)&html_jit_break, 1);
+            break;
+        default:
+            /* HTML_OP_END: html_fuel_return(context, rbp), then the exit below */
+            html_jit_at(&jit, i);
+            html_jit_emit(&jit, "\x48\x89\xee", 3);
+            html_jit_call(&jit, (unsigned long)&html_fuel_return, 0);
+            break;
+        }
+    }
+
+    /* exit: mov rax, rbx; sub rax, r13; add rsp, 8; pop r15; pop r14; pop r13; pop r12; pop rbp; pop rbx; ret */
+    jit.labels[program->length + HTML_JIT_EXIT] = jit.length;
+    html_jit_emit(&jit, "\x48\x89\xd8\x4c\x29\xe8\x48\x83\xc4\x08\x41\x5f\x41\x5e\x41\x5d\x41\x5c\x5d\x5b\xc3",
+                  21);
+    jit.labels[program->length + HTML_JIT_OVERRUN] = jit.length;
+    html_jit_call(&jit, (unsigned long)&html_jit_overrun, 1);
+    html_jit_jump(&jit, "\xe9", 1, program->length + HTML_JIT_EXIT);
+    jit.labels[program->length + HTML_JIT_UNDERRUN] = jit.length;
+    html_jit_call(&jit, (unsigned long)&html_jit_underrun, 1);
+    html_jit_jump(&jit, "\xe9", 1, program->length + HTML_JIT_EXIT);
+
+    /* The slow paths try to grow the tape and retry the operation, or report the error */
+    for (i = 0; i < program->length; i++)
+    {
+        op = program->ops + i;
+        jit.labels[program->length + HTML_JIT_SLOW + i] = jit.length;
+        switch (op->type)
         {
-            int low = context->tape_index - 10;
-            if (low < 0)
-                low = 0;
-            int high = low + 21;
-            if (high >= (int)context->tape_size)
-                high = context->tape_size - 1;
-            for (index = low; index < high; index++)
-                printf("%i\t", index);
-            printf("\n");
-            for (index = low; index < high; index++)
-                printf("%d\t", context->tape[index]);
-            printf("\n");
-            for (index = low; index < high; index++)
-                if (index == context->tape_index)
-                    printf("^\t");
-                else
-                    printf(" \t");
-            printf("\n");
+        case HTML_OP_CHECK:
+            /* lea rsi, [rbx + low]; sub rsi, r13; eax = html_tape_extend(context, rsi); test eax, eax; jz replay */
+            html_jit_emit(&jit, "\x48\x8d\xb3", 3);
+            html_jit_integer(&jit, (unsigned long)op->offset, 4);
+            html_jit_emit(&jit, "\x4c\x29\xee", 3);
+            html_jit_call(&jit, (unsigned long)&html_tape_extend, 0);
+            html_jit_emit(&jit, "\x85\xc0\x74\x3b", 4);
+            /* lea rsi, [rbx + high]; sub rsi, r13; eax = html_tape_extend(context, rsi); test eax, eax; jz replay */
+            html_jit_emit(&jit, "\x48\x8d\xb3", 3);
+            html_jit_integer(&jit, (unsigned long)op->difference, 4);
+            html_jit_emit(&jit, "\x4c\x29\xee", 3);
+            html_jit_call(&jit, (unsigned long)&html_tape_extend, 0);
+            html_jit_emit(&jit, "\x85\xc0\x74\x1e", 4);
+            /* Continue after the check with the new bounds */
+            html_jit_bounds(&jit);
+            html_jit_jump(&jit, "\xe9", 1, i + 1);
+            /* replay: execute the block with checks, which reports the error */
+            html_jit_at(&jit, i);
+            html_jit_emit(&jit, "\x4c\x89\xe7\x48\xbe", 5);
+            html_jit_integer(&jit, (unsigned long)op, 8);
+            html_jit_emit(&jit, "\x48\x89\xda\x4c\x29\xea\x48\xb8", 8);
+            html_jit_integer(&jit, (unsigned long)&html_execute_block_checked, 8);
+            html_jit_emit(&jit, "\xff\xd0", 2);
+            html_jit_jump(&jit, "\xe9", 1, program->length + HTML_JIT_EXIT);
+            break;
+        case HTML_OP_MOVE:
+        case HTML_OP_MULTIPLY:
+            /* mov rsi, rax or mov rsi, rcx; sub rsi, r13; eax = html_tape_extend(context, rsi) */
+            html_jit_emit(&jit, op->type == HTML_OP_MOVE ? "\x48\x89\xc6" : "\x48\x89\xce", 3);
+            html_jit_emit(&jit, "\x4c\x29\xee", 3);
+            html_jit_call(&jit, (unsigned long)&html_tape_extend, 0);
+            /* test eax, eax; jz fail; retry the operation with the new bounds */
+            html_jit_emit(&jit, "\x85\xc0\x74\x1e", 4);
+            html_jit_bounds(&jit);
+            html_jit_jump(&jit, "\xe9", 1, i);
+            /* fail: lea rax, [rbx + offset]; cmp rax, r13; jb underrun; jmp overrun */
+            html_jit_at(&jit, i);
+            html_jit_emit(&jit, "\x48\x8d\x83", 3);
+            html_jit_integer(&jit, (unsigned long)(op->type == HTML_OP_MOVE ? op->difference : op->offset), 4);
+            html_jit_jump(&jit, "\x4c\x39\xe8\x0f\x82", 5, program->length + HTML_JIT_UNDERRUN);
+            html_jit_jump(&jit, "\xe9", 1, program->length + HTML_JIT_OVERRUN);
+            break;
+        case HTML_OP_LOOP_END:
+            /* rax = html_fuel_refill(context); test rax, rax; jz halt; lea rbp, [rax - 1]; jmp the loop body */
+            html_jit_call(&jit, (unsigned long)&html_fuel_refill, 0);
+            html_jit_emit(&jit, "\x48\x85\xc0\x74\x09\x48\x8d\x68\xff", 9);
+            html_jit_jump(&jit, "\xe9", 1, (size_t)op->jump + 1);
+            /* halt: html_jit_halt(context, index, i, program), resuming at this operation */
+            html_jit_emit(&jit, "\xba", 1);
+            html_jit_integer(&jit, (unsigned long)i, 4);
+            html_jit_emit(&jit, "\x48\xb9", 2);
+            html_jit_integer(&jit, (unsigned long)program, 8);
+            html_jit_call(&jit, (unsigned long)&html_jit_halt, 1);
+            html_jit_jump(&jit, "\xe9", 1, program->length + HTML_JIT_EXIT);
             break;
         }
-        default:
-            return;
+    }
+
+    code = MAP_FAILED;
+    if (!jit.failed)
+    {
+        for (i = 0; i < jit.fixups_length; i += 2)
+        {
+            size_t position = jit.fixups[i];
+            long displacement = (long)jit.labels[jit.fixups[i + 1]] - (long)(position + 4);
+            int j;
+            for (j = 0; j < 4; j++)
+                jit.code[position + j] = (unsigned char)((unsigned long)displacement >> (8 * j));
         }
-        instruction = instruction->next;
+        /* Never map the code writable and executable at the same time */
+        code = mmap(NULL, jit.length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (code != MAP_FAILED)
+        {
+            memcpy(code, jit.code, jit.length);
+            if (mprotect(code, jit.length, PROT_READ | PROT_EXEC) != 0)
+            {
+                munmap(code, jit.length);
+                code = MAP_FAILED;
+            }
+        }
+    }
+    free(jit.code);
+    free(jit.fixups);
+    if (code == MAP_FAILED)
+    {
+        free(jit.labels);
+        return -1;
+    }
+    program->code = code;
+    program->code_size = jit.length;
+    /* The labels of the operations are where stopped programs resume */
+    program->code_offsets = jit.labels;
+    return 0;
+}
+
+/**
+ * Executes the given program as the machine code html_compile generated.
+ *
+ * @param program The program to execute.
+ * @param context The context of this execution.
+ * @return 0 if the program was executed, -1 if it has no machine code.
+ */
+static int html_execute_jit(const HtmlProgram *program, HtmlExecutionContext *context)
+{
+    long (*function)(HtmlExecutionContext *, unsigned char *, long, void *);
+    void *resume = 0;
+    void *code = program->code;
+
+    if (code == NULL)
+        return -1;
+    *(void **)&function = code;
+    if (context->resume_position != 0)
+        resume = (unsigned char *)code + program->code_offsets[context->resume_position];
+    context->tape_index = (int)function(context, context->tape, context->tape_index, resume);
+    return 0;
+}
+#endif
+
+/**
+ * Runs the given compiled program on the engine that fits the tape of the
+ * 	given context.
+ *
+ * @param program The program to run.
+ * @param context The context of this execution.
+ */
+static void html_run_program(const HtmlProgram *program, HtmlExecutionContext *context)
+{
+    /* The JIT only knows the tape array of bytes */
+    int jit = context->engine == HTML_ENGINE_JIT && context->cell_size == 1;
+    /* Sparse tapes have engines of their own */
+    if (context->tape_pages != NULL)
+        html_engine(context, HTML_ENGINES_SPARSE)(program, context);
+#ifdef HTML_HAVE_GUARD
+    /* No operation may skip over a guard region */
+    else if ((context->tape_options & HTML_TAPE_GUARDED) && !jit && program->reach < HTML_TAPE_GUARD_SIZE)
+        html_execute_guarded(program, context);
+#endif
+#ifdef HTML_HAVE_JIT
+    else if (jit && html_execute_jit(program, context) == 0)
+    {
+        /* The machine code ran the program */
+    }
+#endif
+    else
+        html_engine(context, HTML_ENGINES_CHECKED)(program, context);
+}
+
+/**
+ * Executes the given compiled program with the engine selected in the context.
+ *
+ * @param program The program to execute.
+ * @param context The context of this execution that contains the tape and
+ *	other execution related variables.
+ * @return How and where the execution ended.
+ */
+HtmlStatus html_execute_program(const HtmlProgram *program, HtmlExecutionContext *context)
+{
+    HtmlStatus status = {HTML_EXECUTION_DONE, HTML_POSITION_UNKNOWN, NULL, 0};
+    if (program == NULL || context == NULL)
+        return status;
+    /* Continue a program that stopped in this context, start any other one */
+    if (context->resume_program != program || context->resume_serial != program->serial ||
+        context->resume_position >= program->length)
+        context->resume_position = 0;
+    context->resume_program = 0;
+    HtmlUnwind unwind;
+    void *previous = context->unwind;
+    int failed = 1;
+    context->status = status;
+    context->unwind = &unwind;
+    if (HTML_UNWIND_SET(unwind) == 0)
+    {
+        html_run_program(program, context);
+        context->status.code = html_execution_status(context, context->resume_program != NULL);
+        failed = 0;
+    }
+#ifdef HTML_HAVE_GUARD
+    /* An error in a guarded execution unwinds past the end of it */
+    html_guarded_context = 0;
+#endif
+    return html_finish(context, previous, failed);
+}
+
+/**
+ * Takes the output that was written into the buffer of the caller by moving
+ * 	the buffer past it, until no space is left.
+ *
+ * @param context The context of the execution.
+ * @param buffer The output, at the start of the buffer.
+ * @param length The number of bytes of output.
+ * @return 0, the output is already where it belongs.
+ */
+static int html_buffer_sink(HtmlExecutionContext *context, const char *buffer, size_t length)
+{
+    (void)buffer;
+    context->output_buffer += length;
+    context->output_capacity -= length;
+    return 0;
+}
+
+/**
+ * Executes the given program in the given context from a cleared tape, with
+ * 	input from and output into buffers of the caller.
+ *
+ * @param program The program to execute.
+ * @param context The context of this execution.
+ * @param input The input of the program.
+ * @param input_length The number of bytes of input.
+ * @param output The buffer the output is written into.
+ * @param output_capacity The number of bytes <code>output</code> can hold.
+ * @param status Where to store how and where the execution ended, or
+ * 	<code>NULL</code>.
+ * @return The number of bytes written into <code>output</code>.
+ */
+size_t html_run_buffer(const HtmlProgram *program, HtmlExecutionContext *context, const char *input,
+                       size_t input_length, char *output, size_t output_capacity, HtmlStatus *status)
+{
+    /* The input and output the context had before, which it gets back afterwards */
+    HtmlExecutionContext saved = *context;
+    HtmlStatus result;
+    size_t length;
+
+    html_context_reset(context);
+    html_set_input_buffer(context, input != NULL ? input : "", input != NULL ? input_length : 0);
+    /* The output goes straight into the buffer of the caller, which is never flushed anywhere */
+    context->output_buffer = output;
+    context->output_capacity = output_capacity;
+    context->output_sink = &html_buffer_sink;
+    result = html_execute_program(program, context);
+    length = (size_t)(context->output_buffer - output) + context->output_length;
+    context->output_buffer = saved.output_buffer;
+    context->output_capacity = saved.output_capacity;
+    context->output_sink = saved.output_sink;
+    context->output_length = 0;
+    context->input_fd = saved.input_fd;
+    context->input_source = saved.input_source;
+    context->input_data = saved.input_data;
+    context->input_position = saved.input_position;
+    context->input_length = saved.input_length;
+    if (status != NULL)
+        *status = result;
+    return length;
+}
+
+/**
+ * Destroys a compiled program.
+ *
+ * @param program The program to destroy.
+ */
+void html_destroy_program(HtmlProgram *program)
+{
+    if (program == NULL)
+        return;
+#ifdef HTML_HAVE_JIT
+    if (program->code != NULL)
+        munmap(program->code, program->code_size);
+    free(program->code_offsets);
+#endif
+    free(program->ops);
+    free(program);
+}
+
+/* The helper functions of emitted C programs, each used by some operations */
+static const char *html_emit_c_bounds =
+    "static void overrun(void)\n"
+    "{\n"
+    "    fprintf(stderr, \"error: tape memory out of bounds (overrun)\\nexceeded the tape size of %ld cells\\n\", (long)TAPE_SIZE);\n"
+    "    exit(EXIT_FAILURE);\n"
+    "}\n\n"
+    "static void underrun(void)\n"
+    "{\n"
+    "    fprintf(stderr, \"error: tape memory out of bounds (underrun)\\nundershot the tape size of %ld cells\\n\", (long)TAPE_SIZE);\n"
+    "    exit(EXIT_FAILURE);\n"
+    "}\n\n"
+    "static long cell(long index)\n"
+    "{\n"
+    "    if (index >= TAPE_SIZE)\n"
+    "        overrun();\n"
+    "    if (index < -TAPE_LOW)\n"
+    "        underrun();\n"
+    "    return index;\n"
+    "}\n\n";
+
+static const char *html_emit_c_output =
+    "static void output(unsigned char value, int count)\n"
+    "{\n"
+    "    while (count-- > 0)\n"
+    "        putchar(value);\n"
+    "}\n\n";
+
+static const char *html_emit_c_input =
+    "static void input(unsigned char *target, int count)\n"
+    "{\n"
+    "    int ch;\n"
+    "    while (count-- > 0)\n"
+    "    {\n"
+    "        if ((ch = getchar()) != EOF)\n"
+    "            *target = (unsigned char)ch;\n"
+    "        else if (EOF_BEHAVIOR != 1)\n"
+    "            *target = EOF_BEHAVIOR;\n"
+    "    }\n"
+    "}\n\n";
+
+static const char *html_emit_c_scan =
+    "static long scan(long index, long stride)\n"
+    "{\n"
+    "    const unsigned char *zero;\n"
+    "    if (stride == 1)\n"
+    "    {\n"
+    "        zero = (const unsigned char *)memchr(tape + index, 0, TAPE_SIZE - index);\n"
+    "        if (zero == NULL)\n"
+    "            overrun();\n"
+    "        return zero - tape;\n"
+    "    }\n"
+    "    for (; index < TAPE_SIZE && index >= -TAPE_LOW; index += stride)\n"
+    "        if (!tape[index])\n"
+    "            return index;\n"
+    "    if (index < -TAPE_LOW)\n"
+    "        underrun();\n"
+    "    overrun();\n"
+    "    return index;\n"
+    "}\n\n";
+
+static const char *html_emit_c_print_tape =
+    "static void print_tape(long tape_index)\n"
+    "{\n"
+    "    long index;\n"
+    "    long low = tape_index - 10 < -TAPE_LOW ? -TAPE_LOW : tape_index - 10;\n"
+    "    long high = low + 21 >= TAPE_SIZE ? TAPE_SIZE - 1 : low + 21;\n"
+    "    for (index = low; index < high; index++)\n"
+    "        printf(\"%ld\\t\", index);\n"
+    "    printf(\"\\n\");\n"
+    "    for (index = low; index < high; index++)\n"
+    "        printf(\"%d\\t\", tape[index]);\n"
+    "    printf(\"\\n\");\n"
+    "    for (index = low; index < high; index++)\n"
+    "        printf(index == tape_index ? \"^\\t\" : \" \\t\");\n"
+    "    printf(\"\\n\");\n"
+    "}\n\n";
+
+/**
+ * Writes the index of the cell at the given offset from the current cell.
+ *
+ * @param offset The offset of the cell.
+ * @param checked Whether the index is checked against the bounds of the tape.
+ * @param stream The stream to write to.
+ */
+static void html_emit_c_index(int offset, int checked, FILE *stream)
+{
+    if (checked)
+        fputs("cell(", stream);
+    if (offset == 0)
+        fputs("i", stream);
+    else
+        fprintf(stream, "i %c %ld", offset < 0 ? '-' : '+', labs((long)offset));
+    if (checked)
+        fputs(")", stream);
+}
+
+/**
+ * Writes the C statement of an operation that accesses a cell.
+ *
+ * @param op The operation to write.
+ * @param checked Whether the access is checked against the bounds of the tape.
+ * @param depth The nesting depth of the statement.
+ * @param stream The stream to write to.
+ */
+static void html_emit_c_access(const HtmlOp *op, int checked, int depth, FILE *stream)
+{
+    fprintf(stream, "%*s", 4 * depth, "");
+    switch (op->type)
+    {
+    case HTML_OP_ADD:
+    case HTML_OP_SET:
+        fputs("tape[", stream);
+        html_emit_c_index(op->offset, checked, stream);
+        fprintf(stream, "] %s %d;\n", op->type == HTML_OP_ADD ? "+=" : "=",
+                (unsigned char)op->difference);
+        break;
+    case HTML_OP_OUTPUT:
+        fputs("output(tape[", stream);
+        html_emit_c_index(op->offset, checked, stream);
+        fprintf(stream, "], %d);\n", op->difference);
+        break;
+    case HTML_OP_INPUT:
+        fputs("input(tape + (", stream);
+        html_emit_c_index(op->offset, checked, stream);
+        fprintf(stream, "), %d);\n", op->difference);
+        break;
+    }
+}
+
+/**
+ * Writes a standalone C program that behaves like the given compiled program
+ * 	executed in the given context: it reads from stdin, writes to stdout,
+ * 	treats the end of input according to the <code>eof_behavior</code> of
+ * 	the context and reports tape overruns and underruns with the messages of
+ * 	the interpreter. A bidirectional tape gets as many cells left of cell 0
+ * 	as right of it.
+ *
+ * @param program The program to translate.
+ * @param context The context whose tape and input settings the emitted
+ * 	program takes.
+ * @param stream The stream to write the C source code to.
+ * @return 0 on success, -1 if the stream reported an error.
+ */
+int html_emit_c(const HtmlProgram *program, const HtmlExecutionContext *context, FILE *stream)
+{
+    int bounds = 0, output = 0, input = 0, scan = 0, print_tape = 0;
+    int depth = 1;
+    const HtmlOp *op, *access;
+    size_t i;
 
-        if (context->shouldStop == 1)
+    for (i = 0; i < program->length; i++)
+    {
+        switch (program->ops[i].type)
         {
-            instruction = NULL;
-            return;
+        case HTML_OP_OUTPUT:
+            output = 1;
+            break;
+        case HTML_OP_INPUT:
+            input = 1;
+            break;
+        case HTML_OP_SCAN:
+            scan = bounds = 1;
+            break;
+        case HTML_OP_BREAK:
+            print_tape = 1;
+            break;
+        case HTML_OP_MOVE:
+        case HTML_OP_CHECK:
+        case HTML_OP_MULTIPLY:
+            bounds = 1;
+            break;
+        }
+    }
+
+    fprintf(stream, "/* Generated by html %d.%d.%d */\n", HTML_VERSION_MAJOR,
+            HTML_VERSION_MINOR, HTML_VERSION_PATCH);
+    fputs("#include <stdio.h>\n#include <stdlib.h>\n#include <string.h>\n\n", stream);
+    fprintf(stream, "#define TAPE_SIZE %ldL\n#define TAPE_LOW %ldL\n#define EOF_BEHAVIOR %d\n\n",
+            (long)context->tape_limit,
+            context->tape_options & HTML_TAPE_BIDIRECTIONAL ? (long)context->tape_limit : 0L,
+            context->eof_behavior);
+    /* Cell 0 sits TAPE_LOW cells into the storage, the cells left of it are negative */
+    fputs("static unsigned char cells[TAPE_LOW + TAPE_SIZE];\n#define tape (cells + TAPE_LOW)\n\n", stream);
+    if (bounds)
+        fputs(html_emit_c_bounds, stream);
+    if (output)
+        fputs(html_emit_c_output, stream);
+    if (input)
+        fputs(html_emit_c_input, stream);
+    if (scan)
+        fputs(html_emit_c_scan, stream);
+    if (print_tape)
+        fputs(html_emit_c_print_tape, stream);
+    fputs("int main(void)\n{\n    long i = 0;\n", stream);
+
+    for (op = program->ops; op->type != HTML_OP_END; op++)
+    {
+        switch (op->type)
+        {
+        case HTML_OP_ADD:
+        case HTML_OP_SET:
+        case HTML_OP_OUTPUT:
+        case HTML_OP_INPUT:
+            html_emit_c_access(op, 0, depth, stream);
+            break;
+        case HTML_OP_CHECK:
+            /* Replay the block with a check per access to report the first failing one */
+            fprintf(stream, "%*sif (", 4 * depth, "");
+            html_emit_c_index(op->offset, 0, stream);
+            fputs(" < -TAPE_LOW || ", stream);
+            html_emit_c_index(op->difference, 0, stream);
+            fprintf(stream, " >= TAPE_SIZE)\n%*s{\n", 4 * depth, "");
+            for (access = op + 1; access->type == HTML_OP_ADD || access->type == HTML_OP_SET ||
+                                  access->type == HTML_OP_OUTPUT || access->type == HTML_OP_INPUT;
+                 access++)
+                html_emit_c_access(access, 1, depth + 1, stream);
+            fprintf(stream, "%*s}\n", 4 * depth, "");
+            break;
+        case HTML_OP_MULTIPLY:
+            fprintf(stream, "%*sif (tape[i])\n%*stape[", 4 * depth, "", 4 * (depth + 1), "");
+            html_emit_c_index(op->offset, 1, stream);
+            fprintf(stream, "] += %uu * tape[i];\n", (unsigned int)op->difference);
+            break;
+        case HTML_OP_SCAN:
+            fprintf(stream, "%*si = scan(i, %d);\n", 4 * depth, "", op->difference);
+            break;
+        case HTML_OP_MOVE:
+            fprintf(stream, "%*si = ", 4 * depth, "");
+            html_emit_c_index(op->difference, 1, stream);
+            fputs(";\n", stream);
+            break;
+        case HTML_OP_LOOP_START:
+            fprintf(stream, "%*swhile (tape[i])\n%*s{\n", 4 * depth, "", 4 * depth, "");
+            depth++;
+            break;
+        case HTML_OP_LOOP_END:
+            depth--;
+            fprintf(stream, "%*s}\n", 4 * depth, "");
+            break;
+        case HTML_OP_BREAK:
+            fprintf(stream, "%*sprint_tape(i);\n", 4 * depth, "");
+            break;
         }
     }
+    fputs("    return EXIT_SUCCESS;\n}\n", stream);
+    return ferror(stream) ? -1 : 0;
 }
 
 /*
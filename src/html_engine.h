@@ -0,0 +1,223 @@
+/*
+ * Copyright 2020 Joerg Bartnick:
+ * Based on the Brainfuck interpreter by
+ *
+ * Copyright 2016 Fabian Mastenbroek
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Template of the engine that executes compiled html programs. This file is
+ * 	included by html.c once per engine variant, with the following macros set:
+ *
+ * HTML_ENGINE_NAME        The name of the generated function.
+ * HTML_ENGINE_CELL        The type of the cells, which must match the cell
+ *                         size of the contexts the function runs on.
+ * HTML_THREADED_DISPATCH  If defined, every operation dispatches the next one
+ *                         through a table of label addresses (a GNU C extension)
+ *                         instead of returning to a shared switch statement.
+ * HTML_ENGINE_UNCHECKED   If defined, the operations do not check the tape
+ *                         bounds. Only used for guarded tapes, whose guard
+ *                         regions catch the accesses outside of the tape.
+ * HTML_ENGINE_SPARSE      If defined, the cells are looked up in the pages of
+ *                         a sparse tape instead of the tape array.
+ */
+
+#ifndef HTML_ENGINE_NAME
+#error "HTML_ENGINE_NAME must be defined before including html_engine.h"
+#endif
+#ifndef HTML_ENGINE_CELL
+#error "HTML_ENGINE_CELL must be defined before including html_engine.h"
+#endif
+
+#ifdef HTML_THREADED_DISPATCH
+#define HTML_CASE(name) op_##name:
+#define HTML_DISPATCH() goto *labels[op->type]
+#else
+#define HTML_CASE(name) case HTML_OP_##name:
+#define HTML_DISPATCH() continue
+#endif
+
+#ifdef HTML_ENGINE_SPARSE
+#define HTML_CELL(cell) (*HTML_SPARSE_CELL(context, cell, HTML_ENGINE_CELL))
+#else
+#define HTML_CELL(cell) tape[cell]
+#endif
+
+/* Records the current operation and cell for the status of an error */
+#define HTML_AT()                                         \
+    {                                                     \
+        context->status.position = (size_t)(op - ops);    \
+        context->tape_index = (int)index;                 \
+    }
+
+/* Advances to the next operation */
+#define HTML_NEXT()      \
+    {                    \
+        op++;            \
+        HTML_DISPATCH(); \
+    }
+
+static void HTML_ENGINE_NAME(const HtmlProgram *program, HtmlExecutionContext *context)
+{
+#ifdef HTML_THREADED_DISPATCH
+    /* Indexed by the HTML_OP_* values */
+    static void *labels[] = {
+        &&op_END, &&op_ADD, &&op_MOVE, &&op_OUTPUT, &&op_INPUT,
+        &&op_LOOP_START, &&op_LOOP_END, &&op_BREAK, &&op_SET,
+        &&op_MULTIPLY, &&op_SCAN, &&op_CHECK};
+#endif
+    const HtmlOp *ops = program->ops;
+    const HtmlOp *op = ops + context->resume_position;
+    /* The loop iterations left in the fuel slice, the only check a stop request needs */
+    long budget = html_fuel_refill(context);
+#ifndef HTML_ENGINE_SPARSE
+    HTML_ENGINE_CELL *tape = (HTML_ENGINE_CELL *)context->tape;
+#endif
+    long index = context->tape_index;
+#ifndef HTML_ENGINE_UNCHECKED
+    long size = (long)context->tape_size;
+    long low = -(long)context->tape_low;
+#endif
+
+#ifdef HTML_THREADED_DISPATCH
+    HTML_DISPATCH();
+#else
+    for (;;)
+    {
+        switch (op->type)
+        {
+#endif
+        HTML_CASE(ADD)
+            HTML_CELL(index + op->offset) += op->difference;
+            HTML_NEXT();
+        HTML_CASE(SET)
+            HTML_CELL(index + op->offset) = op->difference;
+            HTML_NEXT();
+        HTML_CASE(CHECK)
+#ifndef HTML_ENGINE_UNCHECKED
+            if (index + op->offset < low || index + op->difference >= size)
+            {
+                context->status.position = (size_t)(op - ops);
+                op = html_execute_block_checked(context, op, index);
+                size = (long)context->tape_size;
+                low = -(long)context->tape_low;
+            }
+#endif
+            HTML_NEXT();
+        HTML_CASE(MULTIPLY)
+        {
+            unsigned int value = HTML_CELL(index);
+            if (value)
+            {
+#ifndef HTML_ENGINE_UNCHECKED
+                if (index + op->offset >= size)
+                {
+                    HTML_AT();
+                    if (!html_tape_extend(context, index + op->offset))
+                        html_tape_overrun(context);
+                    size = (long)context->tape_size;
+                }
+                if (index + op->offset < low)
+                {
+                    HTML_AT();
+                    if (!html_tape_extend(context, index + op->offset))
+                        html_tape_underrun(context);
+                    low = -(long)context->tape_low;
+                }
+#endif
+                HTML_CELL(index + op->offset) += (unsigned int)op->difference * value;
+            }
+            HTML_NEXT();
+        }
+        HTML_CASE(SCAN)
+            HTML_AT();
+            index = html_scan(context, index, op->difference);
+#ifndef HTML_ENGINE_UNCHECKED
+            size = (long)context->tape_size;
+            low = -(long)context->tape_low;
+#endif
+            HTML_NEXT();
+        HTML_CASE(MOVE)
+#ifndef HTML_ENGINE_UNCHECKED
+            if (index + op->difference >= size)
+            {
+                HTML_AT();
+                if (!html_tape_extend(context, index + op->difference))
+                    html_tape_overrun(context);
+                size = (long)context->tape_size;
+            }
+            if (index + op->difference < low)
+            {
+                HTML_AT();
+                if (!html_tape_extend(context, index + op->difference))
+                    html_tape_underrun(context);
+                low = -(long)context->tape_low;
+            }
+#endif
+            index += op->difference;
+            HTML_NEXT();
+        HTML_CASE(OUTPUT)
+            HTML_AT();
+            html_output(context, (unsigned char)HTML_CELL(index + op->offset), op->difference);
+            HTML_NEXT();
+        HTML_CASE(INPUT)
+            HTML_AT();
+            html_input(context, (unsigned char *)&HTML_CELL(index + op->offset), op->difference);
+            HTML_NEXT();
+        HTML_CASE(LOOP_START)
+            if (!HTML_CELL(index))
+                op = ops + op->jump;
+            HTML_NEXT();
+        HTML_CASE(LOOP_END)
+            if (HTML_CELL(index))
+            {
+                if (--budget < 0 && (budget = html_fuel_refill(context) - 1) < 0)
+                {
+                    /* Resume at this operation, which charges the iteration again */
+                    html_halt(context, program, (size_t)(op - ops));
+                    HTML_AT();
+                    return;
+                }
+                op = ops + op->jump;
+            }
+            HTML_NEXT();
+        HTML_CASE(BREAK)
+            HTML_AT();
+            html_print_tape(context);
+            HTML_NEXT();
+        HTML_CASE(END)
+            html_fuel_return(context, budget);
+            HTML_AT();
+            return;
+#ifndef HTML_THREADED_DISPATCH
+        default:
+            html_fuel_return(context, budget);
+            HTML_AT();
+            return;
+        }
+    }
+#endif
+}
+
+#undef HTML_AT
+#undef HTML_CASE
+#undef HTML_DISPATCH
+#undef HTML_NEXT
+#undef HTML_CELL
+#undef HTML_ENGINE_NAME
+#undef HTML_ENGINE_CELL
+#undef HTML_THREADED_DISPATCH
+#undef HTML_ENGINE_UNCHECKED
+#undef HTML_ENGINE_SPARSE
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2020 Joerg Bartnick:
+ * Based on the Brainfuck interpreter by
+ *
+ * Copyright 2016 Fabian Mastenbroek
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Instantiates the engine template for one cell type, once for every kind of
+ * 	tape access and dispatch, and collects the variants in a table. This file
+ * 	is included by html.c once per cell size, with the following macros set:
+ *
+ * HTML_ENGINES_CELL    The type of the cells.
+ * HTML_ENGINES_SUFFIX  The number of bits of the cells, appended to the names
+ *                      of the generated functions and of the table
+ *                      <code>html_engines_SUFFIX</code>.
+ *
+ * The table holds the switch and threaded variants, in that order, of the
+ * 	engines with checks, without checks and for sparse tapes. Variants that
+ * 	are not available on this platform are replaced by the closest one.
+ */
+
+#ifndef HTML_ENGINES_CELL
+#error "HTML_ENGINES_CELL must be defined before including html_engines.h"
+#endif
+
+#define HTML_ENGINES_JOIN2(name, suffix) name##suffix
+#define HTML_ENGINES_JOIN(name, suffix) HTML_ENGINES_JOIN2(name, suffix)
+
+#define HTML_ENGINE_NAME HTML_ENGINES_JOIN(html_execute_switch_, HTML_ENGINES_SUFFIX)
+#define HTML_ENGINE_CELL HTML_ENGINES_CELL
+#include "html_engine.h"
+
+#define HTML_ENGINE_NAME HTML_ENGINES_JOIN(html_execute_switch_sparse_, HTML_ENGINES_SUFFIX)
+#define HTML_ENGINE_CELL HTML_ENGINES_CELL
+#define HTML_ENGINE_SPARSE
+#include "html_engine.h"
+
+#ifdef HTML_HAVE_THREADED_ENGINE
+#define HTML_ENGINE_NAME HTML_ENGINES_JOIN(html_execute_threaded_, HTML_ENGINES_SUFFIX)
+#define HTML_ENGINE_CELL HTML_ENGINES_CELL
+#define HTML_THREADED_DISPATCH
+#include "html_engine.h"
+
+#define HTML_ENGINE_NAME HTML_ENGINES_JOIN(html_execute_threaded_sparse_, HTML_ENGINES_SUFFIX)
+#define HTML_ENGINE_CELL HTML_ENGINES_CELL
+#define HTML_THREADED_DISPATCH
+#define HTML_ENGINE_SPARSE
+#include "html_engine.h"
+#endif
+
+#ifdef HTML_HAVE_GUARD
+#define HTML_ENGINE_NAME HTML_ENGINES_JOIN(html_execute_switch_unchecked_, HTML_ENGINES_SUFFIX)
+#define HTML_ENGINE_CELL HTML_ENGINES_CELL
+#define HTML_ENGINE_UNCHECKED
+#include "html_engine.h"
+
+#ifdef HTML_HAVE_THREADED_ENGINE
+#define HTML_ENGINE_NAME HTML_ENGINES_JOIN(html_execute_threaded_unchecked_, HTML_ENGINES_SUFFIX)
+#define HTML_ENGINE_CELL HTML_ENGINES_CELL
+#define HTML_THREADED_DISPATCH
+#define HTML_ENGINE_UNCHECKED
+#include "html_engine.h"
+#endif
+#endif
+
+#ifdef HTML_HAVE_THREADED_ENGINE
+#define HTML_ENGINES_THREADED(name) HTML_ENGINES_JOIN(html_execute_threaded_##name, HTML_ENGINES_SUFFIX)
+#else
+#define HTML_ENGINES_THREADED(name) HTML_ENGINES_JOIN(html_execute_switch_##name, HTML_ENGINES_SUFFIX)
+#endif
+#ifdef HTML_HAVE_GUARD
+#define HTML_ENGINES_UNCHECKED(dispatch) HTML_ENGINES_JOIN(html_execute_##dispatch##_unchecked_, HTML_ENGINES_SUFFIX)
+#else
+#define HTML_ENGINES_UNCHECKED(dispatch) HTML_ENGINES_JOIN(html_execute_##dispatch##_, HTML_ENGINES_SUFFIX)
+#endif
+
+static const HtmlEngine HTML_ENGINES_JOIN(html_engines_, HTML_ENGINES_SUFFIX)[] = {
+    HTML_ENGINES_JOIN(html_execute_switch_, HTML_ENGINES_SUFFIX),
+    HTML_ENGINES_THREADED(),
+    HTML_ENGINES_UNCHECKED(switch),
+#if defined(HTML_HAVE_GUARD) && defined(HTML_HAVE_THREADED_ENGINE)
+    HTML_ENGINES_UNCHECKED(threaded),
+#else
+    HTML_ENGINES_THREADED(),
+#endif
+    HTML_ENGINES_JOIN(html_execute_switch_sparse_, HTML_ENGINES_SUFFIX),
+    HTML_ENGINES_THREADED(sparse_)};
+
+#undef HTML_ENGINES_THREADED
+#undef HTML_ENGINES_UNCHECKED
+#undef HTML_ENGINES_JOIN
+#undef HTML_ENGINES_JOIN2
+#undef HTML_ENGINES_CELL
+#undef HTML_ENGINES_SUFFIX
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <getopt.h>
 #include <ctype.h>
+#include <errno.h>
 
 #ifdef HTML_EDITLINE_LIB
 #include <editline/readline.h>
@@ -30,13 +31,49 @@
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
 #include <io.h>
 #define isatty _isatty
+#define write _write
+#define fileno _fileno
 #define STDIN_FILENO 0
+#define STDOUT_FILENO 1
 #else
 #include <unistd.h>
 #endif
 
 #include <html.h>
 
+/* Engine used to run programs, or -1 to interpret the instruction list directly */
+#define ENGINE_TREE -1
+
+static int engine = HTML_ENGINE_THREADED;
+
+/* The number of threads source files are parsed with */
+static int parse_threads = 1;
+
+/* Whether programs are translated to C and written to stdout instead of run */
+static int emit_c = 0;
+
+/* The kind of tape programs run on and its size in cells, or 0 for the default */
+static int tape_options = HTML_TAPE_FIXED;
+static size_t tape_cells = 0;
+
+/* Whether the tape also grows left of cell 0 */
+static int bidirectional = 0;
+
+/* The size of the cells, as the HTML_TAPE_CELLS_* option or 0 for bytes */
+static int cell_options = 0;
+
+/* What an input at the end of the input stores in the cell */
+static int eof_behavior = HTML_EOF_BEHAVIOR;
+
+/* The number of loop iterations programs may run */
+static long fuel = HTML_FUEL_UNLIMITED;
+
+/* The code given with -e, which is run instead of files once all options are read */
+static char *eval_code = NULL;
+
+/* Whether the high-water mark of growable tapes is reported when a program ends */
+static int verbose = 0;
+
 /**
  * Print the usage message of this program.
  *
@@ -44,8 +81,19 @@
  */
 void print_usage(char *name)
 {
-    fprintf(stderr, "usage: %s [-evh] [file...]\n", name);
+    fprintf(stderr, "usage: %s [-evhB] [-E engine] [-P threads] [-T tape] [-S cells] [-C bits] [-F eof] [-f fuel] [--jit] [--emit-c] [--verbose] [file...]\n", name);
     fprintf(stderr, "\t-e --eval\t\trun code directly\n");
+    fprintf(stderr, "\t-E --engine\t\tengine to run with: tree, switch, threaded or jit\n");
+    fprintf(stderr, "\t-P --parse-threads\tnumber of threads to parse source files with\n");
+    fprintf(stderr, "\t-T --tape\t\tkind of tape: fixed, growable, guarded or sparse\n");
+    fprintf(stderr, "\t-B --bidirectional\tlet the tape grow left of cell 0 as well\n");
+    fprintf(stderr, "\t-S --tape-size\t\tnumber of cells of the tape, or the most it may grow to\n");
+    fprintf(stderr, "\t-C --cell-bits\t\tsize of the cells: 8, 16 or 32 bits\n");
+    fprintf(stderr, "\t-F --eof\t\tinput at the end of the input: unchanged, zero or minus-one\n");
+    fprintf(stderr, "\t-f --fuel\t\tnumber of loop iterations programs may run\n");
+    fprintf(stderr, "\t   --jit\t\tcompile programs to machine code (same as -E jit)\n");
+    fprintf(stderr, "\t   --emit-c\t\twrite the program as C source code instead of running it\n");
+    fprintf(stderr, "\t   --verbose\t\treport the high-water mark of growable tapes\n");
     fprintf(stderr, "\t-v --version\t\tshow version information\n");
     fprintf(stderr, "\t-h --help\t\tshow a help message\n");
 }
@@ -75,6 +123,170 @@ void initialize_readline()
 }
 #endif
 
+/**
+ * Write the buffered output of a program to stdout with as few system calls
+ * 	as possible.
+ *
+ * @param context The context of the execution that produced the output.
+ * @param buffer The bytes to write.
+ * @param length The number of bytes to write.
+ * @return 0 on success, -1 if the output could not be written.
+ */
+int write_output(HtmlExecutionContext *context, const char *buffer, size_t length)
+{
+    (void)context;
+    /* Keep the order with output written through stdio, like the prompt */
+    fflush(stdout);
+    while (length > 0)
+    {
+        long written = (long)write(STDOUT_FILENO, buffer, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buffer += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+/**
+ * Create an execution context with the tape selected on the command line.
+ *
+ * @return The created context, the program exits if the tape cannot be allocated.
+ */
+HtmlExecutionContext *create_context()
+{
+    size_t size = tape_cells;
+    int options = bidirectional ? tape_options | HTML_TAPE_BIDIRECTIONAL : tape_options;
+    if (size == 0)
+        size = options == HTML_TAPE_FIXED ? HTML_TAPE_SIZE : HTML_TAPE_RESERVE;
+    HtmlExecutionContext *context = html_context_tape(size, options | cell_options);
+    if (context == NULL)
+    {
+        fprintf(stderr, "error: failed to allocate a tape of %zu cells\n", size);
+        exit(EXIT_FAILURE);
+    }
+    context->eof_behavior = eof_behavior;
+    context->fuel = fuel;
+    return context;
+}
+
+/**
+ * Release the given execution context, reporting how much of a growable tape
+ * 	the programs used when asked to.
+ *
+ * @param context The context to release.
+ */
+void destroy_context(HtmlExecutionContext *context)
+{
+    if (verbose && (context->tape_options & HTML_TAPE_GROWABLE))
+        fprintf(stderr, "tape high-water mark: %zu cells\n", context->tape_low + context->tape_size);
+    html_destroy_context(context);
+}
+
+/**
+ * Report why the execution with the given status ended, unless it ran to its end.
+ *
+ * @param status The status of the execution.
+ * @param context The context of the execution.
+ * @return EXIT_SUCCESS if the program ran to its end, otherwise EXIT_FAILURE.
+ */
+int report_status(HtmlStatus status, HtmlExecutionContext *context)
+{
+    switch (status.code)
+    {
+    case HTML_EXECUTION_DONE:
+        return EXIT_SUCCESS;
+    case HTML_EXECUTION_OUT_OF_FUEL:
+        fprintf(stderr, "error: out of fuel after %ld loop iterations\n", fuel);
+        break;
+    case HTML_EXECUTION_OVERRUN:
+        fprintf(stderr, "error: tape memory out of bounds (overrun)\nexceeded the tape size of %zd cells\n",
+                context->tape_limit);
+        break;
+    case HTML_EXECUTION_UNDERRUN:
+        fprintf(stderr, "error: tape memory out of bounds (underrun)\nundershot the tape size of %zd cells\n",
+                context->tape_limit);
+        break;
+    case HTML_EXECUTION_IO_ERROR:
+        fprintf(stderr, "error: failed to write output\n");
+        break;
+    case HTML_EXECUTION_OUT_OF_MEMORY:
+        fprintf(stderr, "error: out of memory\n");
+        break;
+    }
+    return EXIT_FAILURE;
+}
+
+/**
+ * Optimize and compile the given instructions and execute the resulting program
+ * 	with the selected engine, or write it to stdout as C source code.
+ *
+ * @param instruction The start of the linked list of instructions to run.
+ * @param context The context to execute the program in.
+ * @return EXIT_SUCCESS if the program ran to its end, otherwise EXIT_FAILURE.
+ */
+int run_program(HtmlInstruction *instruction, HtmlExecutionContext *context)
+{
+    int result;
+    HtmlStatus status;
+    context->output_sink = &write_output;
+    html_optimize(instruction);
+    if (emit_c)
+    {
+        if (context->cell_size != 1)
+        {
+            fprintf(stderr, "error: C source code can only be emitted for 8-bit cells\n");
+            return EXIT_FAILURE;
+        }
+        HtmlProgram *program = html_compile(instruction);
+        result = EXIT_SUCCESS;
+        if (program == NULL || html_emit_c(program, context, stdout) < 0)
+        {
+            fprintf(stderr, "error: failed to emit C source code\n");
+            result = EXIT_FAILURE;
+        }
+        html_destroy_program(program);
+        return result;
+    }
+    if (engine == ENGINE_TREE)
+    {
+        status = html_execute(instruction, context);
+    }
+    else
+    {
+        context->engine = engine;
+        HtmlProgram *program = html_compile(instruction);
+        if (program == NULL)
+        {
+            fprintf(stderr, "error: out of memory\n");
+            return EXIT_FAILURE;
+        }
+        status = html_execute_program(program, context);
+        html_destroy_program(program);
+        /* A program that ran out of fuel is gone, the next line starts a new one */
+        context->resume_program = 0;
+        context->resume_position = 0;
+    }
+    return report_status(status, context);
+}
+
+/**
+ * Run the given instructions in interactive mode, which ends like a file does
+ * 	when the program leaves the tape or cannot write its output.
+ *
+ * @param instruction The start of the linked list of instructions to run.
+ * @param context The context to execute the program in.
+ */
+void run_line(HtmlInstruction *instruction, HtmlExecutionContext *context)
+{
+    if (run_program(instruction, context) != EXIT_SUCCESS && context->status.code > HTML_EXECUTION_OUT_OF_FUEL)
+        exit(EXIT_FAILURE);
+}
+
 /**
  * Run the given html file.
  *
@@ -84,19 +296,28 @@ void initialize_readline()
 int run_file(FILE *file)
 {
     HtmlState *state = html_state();
-    HtmlExecutionContext *context = html_context(HTML_TAPE_SIZE);
+    HtmlExecutionContext *context = create_context();
+    /* Programs read their input from stdin in blocks, the handler is a fallback */
+    html_set_input_fd(context, STDIN_FILENO);
     if (file == NULL)
     {
-        html_destroy_context(context);
+        destroy_context(context);
         html_destroy_state(state);
         return EXIT_FAILURE;
     }
-    html_add(state, html_parse_stream(file));
-    html_execute(state->root, context);
-    html_destroy_context(context);
-    html_destroy_state(state);
+    HtmlInstruction *instruction = html_parse_fd_parallel(fileno(file), parse_threads);
     fclose(file);
-    return EXIT_SUCCESS;
+    if (instruction == NULL)
+    {
+        destroy_context(context);
+        html_destroy_state(state);
+        return EXIT_FAILURE;
+    }
+    html_add(state, instruction);
+    int result = run_program(state->root, context);
+    destroy_context(context);
+    html_destroy_state(state);
+    return result;
 }
 
 /**
@@ -108,13 +329,21 @@ int run_file(FILE *file)
 int run_string(char *code)
 {
     HtmlState *state = html_state();
-    HtmlExecutionContext *context = html_context(HTML_TAPE_SIZE);
+    HtmlExecutionContext *context = create_context();
+    /* Programs read their input from stdin in blocks, the handler is a fallback */
+    html_set_input_fd(context, STDIN_FILENO);
     HtmlInstruction *instruction = html_parse_string(code);
+    if (instruction == NULL)
+    {
+        destroy_context(context);
+        html_destroy_state(state);
+        return EXIT_FAILURE;
+    }
     html_add(state, instruction);
-    html_execute(state->root, context);
-    html_destroy_context(context);
+    int result = run_program(state->root, context);
+    destroy_context(context);
     html_destroy_state(state);
-    return EXIT_SUCCESS;
+    return result;
 }
 
 /**
@@ -128,7 +357,9 @@ void run_interactive_console()
     printf("Use # to inspect tape\n");
 #endif
     HtmlState *state = html_state();
-    HtmlExecutionContext *context = html_context(HTML_TAPE_SIZE);
+    HtmlExecutionContext *context = create_context();
+    /* Read one character per line typed */
+    context->input_handler = &html_getchar;
     HtmlInstruction *instruction;
 #ifdef HTML_EDITLINE_LIB
     char *line;
@@ -163,8 +394,10 @@ void run_interactive_console()
         }
         instruction = html_parse_string(line);
         free(line);
+        if (instruction == NULL)
+            continue;
         html_add(state, instruction);
-        html_execute(instruction, context);
+        run_line(instruction, context);
     }
 #else
     printf(">> ");
@@ -177,8 +410,11 @@ void run_interactive_console()
             break;
         }
         fflush(stdin);
-        html_add(state, instruction);
-        html_execute(instruction, context);
+        if (instruction != NULL)
+        {
+            html_add(state, instruction);
+            run_line(instruction, context);
+        }
         printf(">> ");
     }
 #endif
@@ -188,6 +424,17 @@ void run_interactive_console()
 static struct option long_options[] = {
     {"help", no_argument, 0, 'h'},
     {"eval", required_argument, 0, 'e'},
+    {"engine", required_argument, 0, 'E'},
+    {"parse-threads", required_argument, 0, 'P'},
+    {"tape", required_argument, 0, 'T'},
+    {"tape-size", required_argument, 0, 'S'},
+    {"bidirectional", no_argument, 0, 'B'},
+    {"cell-bits", required_argument, 0, 'C'},
+    {"eof", required_argument, 0, 'F'},
+    {"fuel", required_argument, 0, 'f'},
+    {"jit", no_argument, &engine, HTML_ENGINE_JIT},
+    {"emit-c", no_argument, &emit_c, 1},
+    {"verbose", no_argument, &verbose, 1},
     {"version", no_argument, 0, 'v'},
     {0, 0, 0, 0}};
 
@@ -200,13 +447,14 @@ static struct option long_options[] = {
 int main(int argc, char *argv[])
 {
     int c;
-    int i = 1;
+    int i;
+    int status = EXIT_SUCCESS;
     int option_index = 0;
 
     while (1)
     {
         option_index = 0;
-        c = getopt_long(argc, argv, "vhe:",
+        c = getopt_long(argc, argv, "vhBe:E:P:T:S:C:F:f:",
                         long_options, &option_index);
         if (c == -1)
             break;
@@ -224,7 +472,98 @@ int main(int argc, char *argv[])
             print_version();
             return EXIT_SUCCESS;
         case 'e':
-            return run_string((char *)optarg);
+            eval_code = (char *)optarg;
+            break;
+        case 'E':
+            if (strcmp(optarg, "tree") == 0)
+                engine = ENGINE_TREE;
+            else if (strcmp(optarg, "switch") == 0)
+                engine = HTML_ENGINE_SWITCH;
+            else if (strcmp(optarg, "threaded") == 0)
+                engine = HTML_ENGINE_THREADED;
+            else if (strcmp(optarg, "jit") == 0)
+                engine = HTML_ENGINE_JIT;
+            else
+            {
+                fprintf(stderr, "error: unknown engine %s\n", optarg);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'P':
+            parse_threads = atoi(optarg);
+            if (parse_threads < 1)
+            {
+                fprintf(stderr, "error: invalid number of threads %s\n", optarg);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'T':
+            if (strcmp(optarg, "fixed") == 0)
+                tape_options = HTML_TAPE_FIXED;
+            else if (strcmp(optarg, "growable") == 0)
+                tape_options = HTML_TAPE_GROWABLE;
+            else if (strcmp(optarg, "guarded") == 0)
+                tape_options = HTML_TAPE_GUARDED;
+            else if (strcmp(optarg, "sparse") == 0)
+                tape_options = HTML_TAPE_SPARSE;
+            else
+            {
+                fprintf(stderr, "error: unknown tape %s\n", optarg);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'B':
+            bidirectional = 1;
+            break;
+        case 'S':
+            if (atol(optarg) < 1)
+            {
+                fprintf(stderr, "error: invalid tape size %s\n", optarg);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            tape_cells = (size_t)atol(optarg);
+            break;
+        case 'C':
+            if (strcmp(optarg, "8") == 0)
+                cell_options = 0;
+            else if (strcmp(optarg, "16") == 0)
+                cell_options = HTML_TAPE_CELLS_16;
+            else if (strcmp(optarg, "32") == 0)
+                cell_options = HTML_TAPE_CELLS_32;
+            else
+            {
+                fprintf(stderr, "error: invalid cell size %s\n", optarg);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'F':
+            if (strcmp(optarg, "unchanged") == 0)
+                eof_behavior = HTML_EOF_UNCHANGED;
+            else if (strcmp(optarg, "zero") == 0)
+                eof_behavior = HTML_EOF_ZERO;
+            else if (strcmp(optarg, "minus-one") == 0)
+                eof_behavior = HTML_EOF_MINUS_ONE;
+            else
+            {
+                fprintf(stderr, "error: unknown end of input behavior %s\n", optarg);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'f':
+            if (atol(optarg) < 0)
+            {
+                fprintf(stderr, "error: invalid fuel %s\n", optarg);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            fuel = atol(optarg);
+            break;
         case '?':
             print_usage(argv[0]);
             return EXIT_FAILURE;
@@ -232,11 +571,19 @@ int main(int argc, char *argv[])
             abort();
         }
     }
-    if (argc > 1)
+    if (eval_code != NULL)
+        return run_string(eval_code);
+    i = optind;
+    if (i < argc)
     {
         while (i < argc)
-            if (run_file(fopen(argv[i++], "r")) == EXIT_FAILURE)
+        {
+            FILE *file = fopen(argv[i++], "r");
+            if (file == NULL)
                 fprintf(stderr, "error: failed to read file %s\n", argv[i - 1]);
+            else if (run_file(file) == EXIT_FAILURE)
+                status = EXIT_FAILURE;
+        }
     }
     else
     {
@@ -247,9 +594,8 @@ int main(int argc, char *argv[])
         }
         else
         {
-            if (run_file(stdin) == EXIT_FAILURE)
-                fprintf(stderr, "error: failed to read from stdin\n");
+            status = run_file(stdin);
         }
     }
-    return EXIT_SUCCESS;
+    return status;
 }
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+#define MAX_CELLS 6
+
+/**
+ * A program with the cells it leaves behind for cells of 8, 16 and 32 bits,
+ * 	and the output it prints for all of them.
+ */
+typedef struct Case
+{
+    const char *name;
+    char *source;
+    const char *input;
+    int eof_behavior;
+    size_t count;
+    unsigned long cells[3][MAX_CELLS];
+    const char *output;
+    size_t output_length;
+} Case;
+
+static char wrap_source[] = "m L mmtttt L tttttttttt hmLttttttttttttttttttttttttttttttHl L T";
+/* Loops that step by 3 run the inverse of 3 modulo the cell size times */
+static char multiply_source[] = "t hmmmLtHl LL ttttt hmmmLttHl LL t hmmmLmmHl";
+static char set_source[] = "ttttt hml ttt L m hml tt";
+/* The cell of 256 is zero only for cells of 8 bits, where the scans stop at it */
+static char scan_forward_source[] = "t LL tttttttttttttttt hmHttttttttttttttttLl t HH hLl t";
+static char scan_backward_source[] = "LLLL tttttttttttttttt hmHttttttttttttttttLl t HH t LL hHl t";
+static char eof_source[] = "MT LttttttMT";
+
+static Case cases[] = {
+    {"wrap", wrap_source, "", HTML_EOF_UNCHANGED, 4,
+     {{255, 2, 0, 44}, {65535, 2, 0, 300}, {4294967295UL, 2, 0, 300}}, ",", 1},
+    {"multiply", multiply_source, "", HTML_EOF_UNCHANGED, 6,
+     {{0, 171, 0, 174, 0, 170},
+      {0, 43691, 0, 43694, 0, 43690},
+      {0, 2863311531UL, 0, 2863311534UL, 0, 2863311530UL}},
+     "", 0},
+    {"set", set_source, "", HTML_EOF_UNCHANGED, 2, {{3, 2}, {3, 2}, {3, 2}}, "", 0},
+    {"scan forward", scan_forward_source, "", HTML_EOF_UNCHANGED, 4,
+     {{1, 1, 1, 0}, {1, 256, 1, 1}, {1, 256, 1, 1}}, "", 0},
+    {"scan backward", scan_backward_source, "", HTML_EOF_UNCHANGED, 5,
+     {{0, 0, 1, 1, 1}, {0, 1, 1, 256, 1}, {0, 1, 1, 256, 1}}, "", 0},
+    {"eof unchanged", eof_source, "A", HTML_EOF_UNCHANGED, 2, {{65, 6}, {65, 6}, {65, 6}}, "A\x06", 2},
+    {"eof zero", eof_source, "A", HTML_EOF_ZERO, 2, {{65, 0}, {65, 0}, {65, 0}}, "A\x00", 2},
+    {"eof minus-one", eof_source, "A", HTML_EOF_MINUS_ONE, 2,
+     {{65, 255}, {65, 65535}, {65, 4294967295UL}}, "A\xff", 2},
+};
+
+static const int widths[] = {0, HTML_TAPE_CELLS_16, HTML_TAPE_CELLS_32};
+
+/**
+ * Reads the value of a cell of the given context, whatever its size.
+ */
+static unsigned long load(const HtmlExecutionContext *context, int index)
+{
+    const unsigned char *cell = context->tape + (size_t)index * context->cell_size;
+    unsigned short half;
+    unsigned int word;
+    switch (context->cell_size)
+    {
+    case 2:
+        memcpy(&half, cell, sizeof(half));
+        return half;
+    case 4:
+        memcpy(&word, cell, sizeof(word));
+        return word;
+    }
+    return *cell;
+}
+
+/**
+ * Runs the program of the given case on every size of cells with every
+ * 	engine, and compares the cells it leaves behind and its output.
+ */
+static int check(const Case *test)
+{
+    TestProgram program;
+    HtmlStatus status;
+    Output output;
+    int failed = 0;
+    size_t i, j, k;
+
+    test_compile(&program, test->source, 1);
+    for (i = 0; i < sizeof(widths) / sizeof(widths[0]); i++)
+    {
+        for (j = 0; j < ENGINE_COUNT; j++)
+        {
+            HtmlExecutionContext *context = html_context_tape(HTML_TAPE_SIZE, HTML_TAPE_FIXED | widths[i]);
+            test_capture(context, &output);
+            context->eof_behavior = test->eof_behavior;
+            html_set_input_buffer(context, test->input, strlen(test->input));
+            status = test_run(&program, context, engines[j]);
+            for (k = 0; k < test->count && load(context, (int)k) == test->cells[i][k]; k++)
+            {
+            }
+            if (status.code != HTML_EXECUTION_DONE || k < test->count ||
+                !test_output_is(&output, test->output, test->output_length))
+            {
+                fprintf(stderr, "%s with %d-byte cells and engine %d: status %d", test->name, context->cell_size,
+                        engines[j], status.code);
+                if (k < test->count)
+                    fprintf(stderr, ", cell %lu is %lu instead of %lu", (unsigned long)k, load(context, (int)k),
+                            test->cells[i][k]);
+                fprintf(stderr, ", %lu bytes of output\n", (unsigned long)output.length);
+                failed = 1;
+            }
+            html_destroy_context(context);
+        }
+    }
+    test_destroy(&program);
+    return failed;
+}
+
+/**
+ * Checks that cells of every size wrap around at their size, in additions
+ * 	and in the multiplications the optimizer turns loops into, that scans
+ * 	look at whole cells, and that every end of input behavior stores what it
+ * 	should.
+ */
+int main()
+{
+    int failed = 0;
+    size_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+        failed |= check(cases + i);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,45 @@
+# Compiles the C source code that html emits for a program and checks that the
+# resulting executable prints the same output as the interpreter.
+#
+# Expects the following variables:
+#   HTML      The html executable.
+#   CC        The C compiler to build the emitted source code with.
+#   PROGRAM   The html program to test.
+#   WORK_DIR  The directory to write the source code and executable to.
+#   FLAGS     Options for html, optional.
+
+get_filename_component(name ${PROGRAM} NAME_WE)
+set(source ${WORK_DIR}/${name}.c)
+set(executable ${WORK_DIR}/${name}${CMAKE_EXECUTABLE_SUFFIX})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+execute_process(COMMAND ${HTML} ${FLAGS} --emit-c ${PROGRAM}
+    OUTPUT_FILE ${source}
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "html --emit-c failed for ${PROGRAM}")
+endif()
+
+execute_process(COMMAND ${CC} -O2 -o ${executable} ${source}
+    RESULT_VARIABLE result
+    ERROR_VARIABLE errors
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "failed to compile ${source}:\n${errors}")
+endif()
+
+execute_process(COMMAND ${HTML} ${FLAGS} ${PROGRAM}
+    INPUT_FILE /dev/null
+    OUTPUT_VARIABLE expected
+    RESULT_VARIABLE expected_result
+)
+execute_process(COMMAND ${executable}
+    INPUT_FILE /dev/null
+    OUTPUT_VARIABLE actual
+    RESULT_VARIABLE actual_result
+)
+if(NOT actual STREQUAL expected OR NOT actual_result EQUAL expected_result)
+    message(FATAL_ERROR "output of ${executable} differs from the interpreter:\n"
+        "expected (${expected_result}): ${expected}\nactual (${actual_result}): ${actual}")
+endif()
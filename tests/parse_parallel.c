@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <html.h>
+
+#define PROGRAMS 200
+#define MAX_LENGTH 4096
+#define MAX_DEPTH 64
+
+static unsigned long seed = 1;
+
+/**
+ * Returns a pseudo random number below the given bound.
+ */
+static int next_random(int bound)
+{
+    seed = seed * 1103515245 + 12345;
+    return (int)((seed >> 16) % (unsigned long)bound);
+}
+
+/**
+ * Generates a random program of tokens, token runs and comments. Balanced
+ * 	programs close every loop, others may contain unmatched loop tokens.
+ */
+static size_t generate(char *program, int balanced)
+{
+    static const char tokens[] = "tmLHTMhl";
+    size_t length = 0, target = (size_t)next_random(MAX_LENGTH);
+    int depth = 0, run;
+    while (length < target)
+    {
+        char c = tokens[next_random(8)];
+        if (next_random(4) == 0)
+            c = " xy\n"[next_random(4)];
+        if (balanced && c == HTML_TOKEN_LOOP_END && depth == 0)
+            continue;
+        if (balanced && c == HTML_TOKEN_LOOP_START && depth == MAX_DEPTH)
+            continue;
+        if (c == HTML_TOKEN_LOOP_START || c == HTML_TOKEN_LOOP_END)
+        {
+            depth += c == HTML_TOKEN_LOOP_START ? 1 : -1;
+            program[length++] = c;
+            continue;
+        }
+        for (run = 1 + next_random(3); run > 0 && length < target; run--)
+            program[length++] = c;
+    }
+    while (balanced && depth-- > 0)
+        program[length++] = HTML_TOKEN_LOOP_END;
+    program[length] = '\0';
+    return length;
+}
+
+/**
+ * Checks whether the two lists contain the same instructions.
+ */
+static int equal(HtmlInstruction *a, HtmlInstruction *b)
+{
+    HtmlInstruction *stack[2 * (MAX_DEPTH + 2)];
+    int depth = 0;
+    for (;;)
+    {
+        if (a == NULL || b == NULL)
+        {
+            if (a != b)
+                return 0;
+            if (depth == 0)
+                return 1;
+            b = stack[--depth];
+            a = stack[--depth];
+            continue;
+        }
+        if (a->type != b->type || a->difference != b->difference ||
+            (a->loop == NULL) != (b->loop == NULL))
+            return 0;
+        if (a->loop != NULL)
+        {
+            stack[depth++] = a->next;
+            stack[depth++] = b->next;
+            a = a->loop;
+            b = b->loop;
+            continue;
+        }
+        a = a->next;
+        b = b->next;
+    }
+}
+
+/**
+ * Checks that parsing with threads gives the same result as the serial parser.
+ */
+int main()
+{
+    static char program[MAX_LENGTH + MAX_DEPTH + 1];
+    HtmlParseError expected_error, actual_error;
+    int i, threads;
+    for (i = 0; i < PROGRAMS; i++)
+    {
+        size_t length = generate(program, i % 4 != 0);
+        HtmlInstruction *expected = i % 4 != 0 ? html_parse_string(program)
+                                               : html_parse_buffer(program, length, &expected_error);
+        for (threads = 2; threads <= 9; threads++)
+        {
+            HtmlInstruction *actual = html_parse_buffer_parallel(program, length, threads, &actual_error);
+            if ((expected == NULL) != (actual == NULL) ||
+                (expected != NULL && !equal(expected, actual)) ||
+                (expected == NULL && (expected_error.type != actual_error.type ||
+                                      expected_error.offset != actual_error.offset)))
+            {
+                fprintf(stderr, "parallel parse with %d threads differs for program %d: %s\n",
+                        threads, i, program);
+                return EXIT_FAILURE;
+            }
+            html_destroy_instructions(actual);
+        }
+        html_destroy_instructions(expected);
+    }
+    return EXIT_SUCCESS;
+}
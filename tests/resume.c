@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+/* The loop iterations a program may run per execution, and the most executions it may take */
+#define FUEL 2
+#define MAX_EXECUTIONS 10000
+
+static char hello_source[] = "tttttttthLtttthLttLtttLtttLtHHHHmlLtLtLmLLthHlHmlLLTLmmmTtttttttTTtttTLLTHmTHTtt"
+                             "tTmmmmmmTmmmmmmmmTLLtTLttT";
+static const char hello_expected[] = "Hello World!\n";
+/* Prints from 10 down to 1, one byte in every iteration of its loop */
+static char countdown_source[] = "tttttttttt hTml";
+static const char countdown_expected[] = "\n\t\b\a\x06\x05\x04\x03\x02\x01";
+/* Clears the cell and prints the letter A */
+static char letter_source[] = "hml tttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttttT";
+
+/* The tree interpreter cannot resume a program, the engines after it can */
+#define FIRST_ENGINE 1
+static const int tapes[] = {HTML_TAPE_FIXED, HTML_TAPE_GROWABLE, HTML_TAPE_GUARDED, HTML_TAPE_SPARSE,
+                            HTML_TAPE_FIXED | HTML_TAPE_CELLS_16, HTML_TAPE_FIXED | HTML_TAPE_CELLS_32};
+
+/**
+ * Runs the given program on every kind of tape with every engine a few loop
+ * 	iterations at a time, stopping it every third execution instead of
+ * 	letting it run out of fuel, and compares the output of all of them with
+ * 	the expected one.
+ */
+static int check(const char *name, char *source, const char *expected)
+{
+    TestProgram program;
+    HtmlStatus status;
+    Output output;
+    int failed = 0;
+    int executions;
+    size_t i, j;
+
+    test_compile(&program, source, 1);
+    for (i = 0; i < sizeof(tapes) / sizeof(tapes[0]); i++)
+    {
+        for (j = FIRST_ENGINE; j < ENGINE_COUNT; j++)
+        {
+            HtmlExecutionContext *context = html_context_tape(HTML_TAPE_SIZE, tapes[i]);
+            test_capture(context, &output);
+            executions = 0;
+            do
+            {
+                if (++executions % 3 == 0)
+                {
+                    context->fuel = HTML_FUEL_UNLIMITED;
+                    html_execution_stop(context);
+                }
+                else
+                    context->fuel = FUEL;
+                status = test_run(&program, context, engines[j]);
+                context->shouldStop = 0;
+            } while ((status.code == HTML_EXECUTION_OUT_OF_FUEL || status.code == HTML_EXECUTION_STOPPED) &&
+                     executions < MAX_EXECUTIONS);
+            /* Every program runs more loop iterations than a single execution may */
+            if (status.code != HTML_EXECUTION_DONE || executions < 3 ||
+                !test_output_is(&output, expected, strlen(expected)))
+            {
+                fprintf(stderr, "%s on tape %d with engine %d: status %d after %d executions, output \"%.*s\"\n",
+                        name, tapes[i], engines[j], status.code, executions, (int)output.length, output.bytes);
+                failed = 1;
+            }
+            html_destroy_context(context);
+        }
+    }
+    test_destroy(&program);
+    return failed;
+}
+
+/**
+ * Runs a program out of fuel, destroys it and runs another one in the same
+ * 	context, which may well be compiled at the same address and has to start
+ * 	at its beginning anyway.
+ */
+static int check_recompiled(int engine)
+{
+    HtmlExecutionContext *context = html_context_tape(HTML_TAPE_SIZE, HTML_TAPE_FIXED);
+    TestProgram program;
+    HtmlStatus status;
+    Output output;
+    int failed = 0;
+
+    test_capture(context, &output);
+    test_compile(&program, countdown_source, 1);
+    context->fuel = 1;
+    status = test_run(&program, context, engine);
+    test_destroy(&program);
+    failed |= status.code != HTML_EXECUTION_OUT_OF_FUEL;
+
+    test_compile(&program, letter_source, 1);
+    output.length = 0;
+    context->fuel = HTML_FUEL_UNLIMITED;
+    status = test_run(&program, context, engine);
+    if (failed || status.code != HTML_EXECUTION_DONE || !test_output_is(&output, "A", 1))
+    {
+        fprintf(stderr, "recompiled with engine %d: status %d, %lu bytes of output\n", engine, status.code,
+                (unsigned long)output.length);
+        failed = 1;
+    }
+    test_destroy(&program);
+    html_destroy_context(context);
+    return failed;
+}
+
+/**
+ * Checks that compiled programs that are stopped or run out of fuel continue
+ * 	where they ended, on every kind of tape and with every engine.
+ */
+int main()
+{
+    int failed = 0;
+    size_t i;
+    failed |= check("hello", hello_source, hello_expected);
+    failed |= check("countdown", countdown_source, countdown_expected);
+    for (i = FIRST_ENGINE; i < ENGINE_COUNT; i++)
+        failed |= check_recompiled(engines[i]);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
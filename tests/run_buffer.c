@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <html.h>
+
+/**
+ * Outputs the marks earlier runs left on the tape and leaves one of its own,
+ * 	then echoes its input with every byte incremented until the input ends.
+ */
+static char echo_source[] = "LLLLLLLLLL hTml t HHHHHHHHHH MhtTMl";
+
+/* The distance of the far cell from cell 0, past the first commit step of growable tapes */
+#define FAR_CELLS 100000
+
+/**
+ * Checks one run of the given program against the expected output and status.
+ */
+static int check(const HtmlProgram *program, HtmlExecutionContext *context, const char *input,
+                 size_t capacity, const char *expected, int code)
+{
+    char output[64];
+    HtmlStatus status;
+    size_t length = html_run_buffer(program, context, input, input != NULL ? strlen(input) : 5, output, capacity,
+                                    &status);
+    if (status.code != code || length != strlen(expected) || memcmp(output, expected, length) != 0)
+    {
+        fprintf(stderr, "run with input \"%s\" and %lu bytes of output: status %d, %lu bytes\n",
+                input != NULL ? input : "(null)", (unsigned long)capacity, status.code, (unsigned long)length);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Runs a program that outputs a single byte and checks that it is 0.
+ */
+static int check_zero(const HtmlProgram *program, HtmlExecutionContext *context)
+{
+    char output[1];
+    HtmlStatus status;
+    size_t length = html_run_buffer(program, context, NULL, 0, output, sizeof(output), &status);
+    if (status.code != HTML_EXECUTION_DONE || length != 1 || output[0] != 0)
+    {
+        fprintf(stderr, "far run on tape %d: status %d, %lu bytes\n", context->tape_options, status.code,
+                (unsigned long)length);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Builds a program that outputs the mark earlier runs left on the cell the
+ * 	given distance away from cell 0 in the given direction and leaves one of
+ * 	its own.
+ */
+static HtmlProgram *far_program(char direction, char back)
+{
+    static char source[2 * FAR_CELLS + 4];
+    HtmlState *state = html_state();
+    HtmlProgram *program;
+    memset(source, direction, FAR_CELLS);
+    memcpy(source + FAR_CELLS, "Tt", 2);
+    memset(source + FAR_CELLS + 2, back, FAR_CELLS);
+    source[2 * FAR_CELLS + 2] = 0;
+    html_add(state, html_parse_string(source));
+    html_optimize(state->root);
+    program = html_compile(state->root);
+    html_destroy_state(state);
+    return program;
+}
+
+/**
+ * Leaves marks far right and far left of cell 0, which the next runs must not
+ * 	see, and checks that a reset tape marks no more than its first cells as
+ * 	touched again.
+ */
+static int check_far(int tape)
+{
+    HtmlProgram *right = far_program(HTML_TOKEN_NEXT, HTML_TOKEN_PREVIOUS);
+    HtmlProgram *left = far_program(HTML_TOKEN_PREVIOUS, HTML_TOKEN_NEXT);
+    HtmlExecutionContext *context = html_context_tape(2 * FAR_CELLS, tape);
+    int failed = 0;
+    int round;
+    for (round = 0; round < 3; round++)
+    {
+        failed |= check_zero(right, context);
+        if (tape & HTML_TAPE_BIDIRECTIONAL)
+            failed |= check_zero(left, context);
+        html_context_reset(context);
+        if (context->tape_low + context->tape_size > HTML_TAPE_COMMIT_SIZE && context->tape_pages == NULL)
+        {
+            fprintf(stderr, "tape %d still spans %lu cells after a reset\n", tape,
+                    (unsigned long)(context->tape_low + context->tape_size));
+            failed = 1;
+        }
+    }
+    html_destroy_context(context);
+    html_destroy_program(right);
+    html_destroy_program(left);
+    return failed;
+}
+
+/**
+ * Runs a program on buffers over and over in the same contexts, which have
+ * 	to start every run on a cleared tape.
+ */
+int main()
+{
+    static const int tapes[] = {HTML_TAPE_FIXED, HTML_TAPE_GROWABLE, HTML_TAPE_GUARDED, HTML_TAPE_SPARSE,
+                                HTML_TAPE_GROWABLE | HTML_TAPE_BIDIRECTIONAL | HTML_TAPE_CELLS_16};
+    HtmlState *state = html_state();
+    HtmlProgram *program;
+    int failed = 0;
+    int i, round;
+
+    html_add(state, html_parse_string(echo_source));
+    html_optimize(state->root);
+    program = html_compile(state->root);
+    for (i = 0; i < 5; i++)
+    {
+        HtmlExecutionContext *context = html_context_tape(HTML_TAPE_SIZE, tapes[i]);
+        context->eof_behavior = HTML_EOF_ZERO;
+        for (round = 0; round < 3; round++)
+        {
+            failed |= check(program, context, "abc", 64, "bcd", HTML_EXECUTION_DONE);
+            failed |= check(program, context, "", 64, "", HTML_EXECUTION_DONE);
+            /* Output that does not fit ends the run, the part that fits is kept */
+            failed |= check(program, context, "hello", 3, "ifm", HTML_EXECUTION_IO_ERROR);
+            failed |= check(program, context, "hello", 5, "ifmmp", HTML_EXECUTION_DONE);
+            /* Without an input buffer its length does not matter */
+            failed |= check(program, context, NULL, 64, "", HTML_EXECUTION_DONE);
+        }
+        html_destroy_context(context);
+        failed |= check_far(tapes[i]);
+    }
+    failed |= check_far(HTML_TAPE_GUARDED | HTML_TAPE_BIDIRECTIONAL);
+    failed |= check_far(HTML_TAPE_SPARSE | HTML_TAPE_BIDIRECTIONAL);
+    html_destroy_program(program);
+    html_destroy_state(state);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,18 +1,62 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <html.h>
+#include <string.h>
+#include "test.h"
+
+/* The bundled examples, which print the same greeting */
+static char hello_source[] = "tttttttthLtttthLttLtttLtttLtHHHHmlLtLtLmLLthHlHmlLLTLmmmTtttttttTTtttTLLTHmTHTtt"
+                             "tTmmmmmmTmmmmmmmmTLLtTLttT";
+static char hello_short_source[] = "tttttttthLtttthLttLtttLtttLtHHHHmlLtLmLtLLthHlHmlLLTL"
+                                   "LmmmTtttttttTTtttTLTHHmTLTtttTmmmmmmTmmmmmmmmTLtTLttT";
+static const char expected[] = "Hello World!\n";
 
 /**
- * Smoke test running a simple "Hello World" html program.
+ * Runs a program with the given engine and compares its output with the
+ * 	greeting.
  */
-int main() {
-    HtmlState *state = html_state();
+static int check(const char *name, const TestProgram *program, int engine)
+{
+    Output output;
+    HtmlStatus status;
     HtmlExecutionContext *context = html_context(HTML_TAPE_SIZE);
-    HtmlInstruction *instruction = html_parse_string("tttttttthLtttthLttLtttLtttLtHHHHmlLtLtLmLLthHlHmlLLTLmmmTtttttttTTtttTLLTHmTHTtt"
-                                                     "tTmmmmmmTmmmmmmmmTLLtTLttT");
-    html_add(state, instruction);
-    html_execute(state->root, context);
+    test_capture(context, &output);
+    status = test_run(program, context, engine);
     html_destroy_context(context);
-    html_destroy_state(state);
-    return EXIT_SUCCESS;
+    if (status.code != HTML_EXECUTION_DONE || !test_output_is(&output, expected, strlen(expected)))
+    {
+        fprintf(stderr, "%s with engine %d: status %d, output \"%.*s\"\n", name, engine, status.code,
+                (int)output.length, output.bytes);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Runs the given program as parsed, then optimized with every engine, which
+ * 	for the JIT falls back to an interpreter when it is not built.
+ */
+static int run(const char *name, char *source)
+{
+    TestProgram program;
+    int failed = 0;
+    size_t i;
+
+    test_compile(&program, source, 0);
+    failed |= check(name, &program, ENGINE_TREE);
+    test_destroy(&program);
+    test_compile(&program, source, 1);
+    for (i = 0; i < ENGINE_COUNT; i++)
+        failed |= check(name, &program, engines[i]);
+    test_destroy(&program);
+    return failed;
+}
+
+/**
+ * Smoke test running the "Hello World" examples with every engine.
+ */
+int main() {
+    int failed = 0;
+    failed |= run("hello", hello_source);
+    failed |= run("hello-short", hello_short_source);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
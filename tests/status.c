@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+#if defined(__linux__) && !defined(__SANITIZE_ADDRESS__)
+#include <sys/resource.h>
+#define HAVE_ADDRESS_LIMIT
+#endif
+
+/* Programs that move right of a tape of two cells, left of it, and print forever */
+static char overrun_source[] = "tLtLtLt";
+static char underrun_source[] = "Ht";
+static char output_source[] = "thTl";
+/* Walk off the right end of the tape, setting every cell on the way */
+static char walk_source[] = "thLtl";
+
+/**
+ * A program that fails, with the status it ends with. The tree interpreter
+ * 	reports the instruction it ended at, the compiled engines the operation.
+ */
+typedef struct Case
+{
+    const char *name;
+    char *source;
+    int tape;
+    size_t size;
+    /* Whether the output sink fails */
+    int sink_fails;
+    int code;
+    /* The operation the compiled engines end at */
+    size_t position;
+    /* The token of the instruction the tree interpreter ends at */
+    char token;
+    long tape_index;
+    long tree_tape_index;
+} Case;
+
+static Case cases[] = {
+    {"overrun", overrun_source, HTML_TAPE_FIXED, 2, 0, HTML_EXECUTION_OVERRUN, 3, HTML_TOKEN_NEXT, 0, 1},
+    {"overrun", overrun_source, HTML_TAPE_GROWABLE, 2, 0, HTML_EXECUTION_OVERRUN, 3, HTML_TOKEN_NEXT, 0, 1},
+    {"underrun", underrun_source, HTML_TAPE_FIXED, 2, 0, HTML_EXECUTION_UNDERRUN, 1, HTML_TOKEN_PREVIOUS, 0, 0},
+    {"underrun", underrun_source, HTML_TAPE_GROWABLE, 2, 0, HTML_EXECUTION_UNDERRUN, 1, HTML_TOKEN_PREVIOUS, 0, 0},
+    {"output", output_source, HTML_TAPE_FIXED, 2, 1, HTML_EXECUTION_IO_ERROR, 2, HTML_TOKEN_OUTPUT, 0, 0},
+};
+
+static int fail_output(HtmlExecutionContext *context, const char *buffer, size_t length)
+{
+    (void)context;
+    (void)buffer;
+    (void)length;
+    return -1;
+}
+
+/**
+ * Runs the program of the given case with every engine and compares the
+ * 	status it ends with.
+ */
+static int check(const Case *test)
+{
+    TestProgram program;
+    HtmlStatus status;
+    int failed = 0;
+    size_t i;
+
+    test_compile(&program, test->source, 1);
+    for (i = 0; i < ENGINE_COUNT; i++)
+    {
+        HtmlExecutionContext *context = html_context_tape(test->size, test->tape);
+        int tree = engines[i] == ENGINE_TREE;
+        if (test->sink_fails)
+            context->output_sink = &fail_output;
+        status = test_run(&program, context, engines[i]);
+        if (status.code != test->code || status.position != (tree ? HTML_POSITION_UNKNOWN : test->position) ||
+            (tree ? status.instruction == NULL || status.instruction->type != test->token
+                  : status.instruction != NULL) ||
+            status.tape_index != (tree ? test->tree_tape_index : test->tape_index))
+        {
+            fprintf(stderr, "%s on tape %d with engine %d: status %d at operation %ld, cell %ld\n", test->name,
+                    test->tape, engines[i], status.code, (long)status.position, status.tape_index);
+            failed = 1;
+        }
+        html_destroy_context(context);
+    }
+    test_destroy(&program);
+    return failed;
+}
+
+/**
+ * Walks off either end of a guarded tape with every engine. The guard regions
+ * 	catch the switch and threaded engines, which cannot tell the operation
+ * 	and report the cell past the end, while the tree interpreter and the JIT
+ * 	check the bounds themselves.
+ */
+static int check_guarded(const char *name, char *source, int tape, int code)
+{
+    TestProgram program;
+    HtmlStatus status;
+    int failed = 0;
+    size_t i;
+
+    test_compile(&program, source, 1);
+    for (i = 0; i < ENGINE_COUNT; i++)
+    {
+        HtmlExecutionContext *context = html_context_tape(HTML_TAPE_SIZE, tape);
+        long limit = (long)context->tape_limit;
+        long past = code == HTML_EXECUTION_OVERRUN ? limit : tape & HTML_TAPE_BIDIRECTIONAL ? -limit - 1 : -1;
+        int guarded = engines[i] == HTML_ENGINE_SWITCH || engines[i] == HTML_ENGINE_THREADED;
+        status = test_run(&program, context, engines[i]);
+        if (status.code != code ||
+            (guarded && (status.position != HTML_POSITION_UNKNOWN || status.tape_index != past)) ||
+            (!guarded && status.position == HTML_POSITION_UNKNOWN && engines[i] != ENGINE_TREE))
+        {
+            fprintf(stderr, "%s on tape %d with engine %d: status %d at operation %ld, cell %ld of %ld\n", name, tape,
+                    engines[i], status.code, (long)status.position, status.tape_index, limit);
+            failed = 1;
+        }
+        html_destroy_context(context);
+    }
+    test_destroy(&program);
+    return failed;
+}
+
+#ifdef HAVE_ADDRESS_LIMIT
+/**
+ * Walks right on a sparse tape a page at a time with every engine until the
+ * 	pages no longer fit in the address space left to the process.
+ */
+static int check_out_of_memory()
+{
+    static char source[HTML_TAPE_PAGE_SIZE + 5];
+    TestProgram program;
+    HtmlStatus status;
+    int failed = 0;
+    size_t i;
+
+    strcpy(source, "th");
+    memset(source + 2, HTML_TOKEN_NEXT, HTML_TAPE_PAGE_SIZE);
+    strcpy(source + 2 + HTML_TAPE_PAGE_SIZE, "tl");
+    test_compile(&program, source, 1);
+    for (i = 0; i < ENGINE_COUNT; i++)
+    {
+        HtmlExecutionContext *context = html_context_tape(HTML_TAPE_RESERVE, HTML_TAPE_SPARSE);
+        struct rlimit previous, limit;
+        unsigned long pages = 0;
+        FILE *statm = fopen("/proc/self/statm", "r");
+        if (statm == NULL || fscanf(statm, "%lu", &pages) != 1 || getrlimit(RLIMIT_AS, &previous) != 0)
+        {
+            fprintf(stderr, "cannot limit the address space\n");
+            return 1;
+        }
+        fclose(statm);
+        /* Room for a few thousand pages, far fewer than the program walks through */
+        limit = previous;
+        limit.rlim_cur = pages * 4096 + (64 << 20);
+        setrlimit(RLIMIT_AS, &limit);
+        status = test_run(&program, context, engines[i]);
+        setrlimit(RLIMIT_AS, &previous);
+        /* The program touches the first cell of every page, which is where it fails */
+        if (status.code != HTML_EXECUTION_OUT_OF_MEMORY || status.position != HTML_POSITION_UNKNOWN ||
+            status.instruction != NULL || status.tape_index <= 0 || status.tape_index % HTML_TAPE_PAGE_SIZE != 0)
+        {
+            fprintf(stderr, "out of memory with engine %d: status %d at operation %ld, cell %ld\n", engines[i],
+                    status.code, (long)status.position, status.tape_index);
+            failed = 1;
+        }
+        html_destroy_context(context);
+    }
+    test_destroy(&program);
+    return failed;
+}
+#endif
+
+/**
+ * Checks that programs that fail report why, and the operation or instruction
+ * 	and the cell they failed at, with every engine.
+ */
+int main()
+{
+    int failed = 0;
+    size_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+        failed |= check(cases + i);
+    failed |= check_guarded("right", walk_source, HTML_TAPE_GUARDED, HTML_EXECUTION_OVERRUN);
+    failed |= check_guarded("left", underrun_source, HTML_TAPE_GUARDED, HTML_EXECUTION_UNDERRUN);
+#ifdef HAVE_ADDRESS_LIMIT
+    failed |= check_out_of_memory();
+#endif
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
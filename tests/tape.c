@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "test.h"
+
+#define TAPE_CELLS 100000
+
+/**
+ * Walk off the right and the left end of the tape, setting every cell on the way.
+ */
+static char right_source[] = "thLtl";
+static char left_source[] = "thHtl";
+
+static const int tapes[] = {HTML_TAPE_FIXED,
+                            HTML_TAPE_GROWABLE,
+                            HTML_TAPE_GUARDED,
+                            HTML_TAPE_GROWABLE | HTML_TAPE_BIDIRECTIONAL,
+                            HTML_TAPE_GUARDED | HTML_TAPE_BIDIRECTIONAL,
+                            HTML_TAPE_SPARSE};
+
+/**
+ * Runs a program that leaves the tape on every kind of tape with every engine
+ * 	and checks that it ends with the given code at the last cell of the
+ * 	tape. Bidirectional tapes end as far left of cell 0 as right of it. The
+ * 	guard regions catch the switch and threaded engines on guarded tapes at
+ * 	the first cell past the end instead.
+ */
+static int check(const char *name, char *source, int code)
+{
+    TestProgram program;
+    HtmlStatus status;
+    int failed = 0;
+    size_t i, j;
+
+    test_compile(&program, source, 1);
+    for (i = 0; i < sizeof(tapes) / sizeof(tapes[0]); i++)
+    {
+        for (j = 0; j < ENGINE_COUNT; j++)
+        {
+            HtmlExecutionContext *context = html_context_tape(TAPE_CELLS, tapes[i]);
+            long limit = (long)context->tape_limit;
+            /* The last cell before the end, the guard regions report the first one past it */
+            long last = code == HTML_EXECUTION_OVERRUN ? limit - 1 : tapes[i] & HTML_TAPE_BIDIRECTIONAL ? -limit : 0;
+            long past = code == HTML_EXECUTION_OVERRUN ? last + 1 : last - 1;
+            int guarded = (tapes[i] & HTML_TAPE_GUARDED) &&
+                          (engines[j] == HTML_ENGINE_SWITCH || engines[j] == HTML_ENGINE_THREADED);
+            status = test_run(&program, context, engines[j]);
+            if (status.code != code || status.tape_index != (guarded ? past : last))
+            {
+                fprintf(stderr, "%s on tape %d with engine %d: status %d at cell %ld of %ld\n", name, tapes[i],
+                        engines[j], status.code, status.tape_index, limit);
+                failed = 1;
+            }
+            html_destroy_context(context);
+        }
+    }
+    test_destroy(&program);
+    return failed;
+}
+
+/**
+ * Checks that programs that walk off either end of every kind of tape report
+ * 	an overrun or an underrun instead of touching memory outside of it.
+ */
+int main()
+{
+    int failed = 0;
+    failed |= check("right", right_source, HTML_EXECUTION_OVERRUN);
+    failed |= check("left", left_source, HTML_EXECUTION_UNDERRUN);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
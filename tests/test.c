@@ -0,0 +1,49 @@
+#include <string.h>
+#include "test.h"
+
+const int engines[ENGINE_COUNT] = {ENGINE_TREE, HTML_ENGINE_SWITCH, HTML_ENGINE_THREADED, HTML_ENGINE_JIT};
+
+static int write_output(HtmlExecutionContext *context, const char *buffer, size_t length)
+{
+    Output *output = (Output *)context->userdata;
+    if (output->length + length > MAX_OUTPUT)
+        return -1;
+    memcpy(output->bytes + output->length, buffer, length);
+    output->length += length;
+    return 0;
+}
+
+void test_compile(TestProgram *program, char *source, int optimize)
+{
+    program->state = html_state();
+    html_add(program->state, html_parse_string(source));
+    if (optimize)
+        html_optimize(program->state->root);
+    program->program = html_compile(program->state->root);
+}
+
+void test_destroy(TestProgram *program)
+{
+    html_destroy_program(program->program);
+    html_destroy_state(program->state);
+}
+
+void test_capture(HtmlExecutionContext *context, Output *output)
+{
+    output->length = 0;
+    context->userdata = output;
+    context->output_sink = &write_output;
+}
+
+HtmlStatus test_run(const TestProgram *program, HtmlExecutionContext *context, int engine)
+{
+    if (engine == ENGINE_TREE)
+        return html_execute(program->state->root, context);
+    context->engine = engine;
+    return html_execute_program(program->program, context);
+}
+
+int test_output_is(const Output *output, const char *expected, size_t length)
+{
+    return output->length == length && memcmp(output->bytes, expected, length) == 0;
+}
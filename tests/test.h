@@ -0,0 +1,79 @@
+#ifndef HTML_TEST_H
+#define HTML_TEST_H
+
+#include <stdio.h>
+#include <html.h>
+
+/* The most bytes of output a test program may print */
+#define MAX_OUTPUT 64
+
+/* The engines the programs are run with, the tree interpreter first */
+#define ENGINE_TREE -1
+#define ENGINE_COUNT 4
+extern const int engines[ENGINE_COUNT];
+
+/**
+ * The output of one execution, reached through the userdata of its context.
+ */
+typedef struct Output
+{
+    char bytes[MAX_OUTPUT];
+    size_t length;
+} Output;
+
+/**
+ * A parsed program with the instructions the tree interpreter runs and the
+ * 	operations the other engines run.
+ */
+typedef struct TestProgram
+{
+    HtmlState *state;
+    HtmlProgram *program;
+} TestProgram;
+
+/**
+ * Parses and compiles the given source code.
+ *
+ * @param program The program to fill in.
+ * @param source The source code of the program.
+ * @param optimize Whether the instructions are optimized before compiling them.
+ */
+void test_compile(TestProgram *program, char *source, int optimize);
+
+/**
+ * Destroys the instructions and operations of a program.
+ *
+ * @param program The program to destroy.
+ */
+void test_destroy(TestProgram *program);
+
+/**
+ * Collects the output of executions in the given context into the given
+ * 	output, which is emptied.
+ *
+ * @param context The context to capture the output of.
+ * @param output The output to collect into.
+ */
+void test_capture(HtmlExecutionContext *context, Output *output);
+
+/**
+ * Runs a program with the given engine on the given context.
+ *
+ * @param program The program to run.
+ * @param context The context of this execution.
+ * @param engine One of the <code>engines</code>.
+ * @return How and where the execution ended.
+ */
+HtmlStatus test_run(const TestProgram *program, HtmlExecutionContext *context, int engine);
+
+/**
+ * Compares the captured output with the expected bytes.
+ *
+ * @param output The captured output.
+ * @param expected The bytes the program should print.
+ * @param length The number of bytes in <code>expected</code>.
+ * @return 1 if they are the same, 0 otherwise.
+ */
+int test_output_is(const Output *output, const char *expected, size_t length);
+
+#endif
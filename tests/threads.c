@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <html.h>
+
+#define THREADS 8
+#define ROUNDS 60
+#define MAX_OUTPUT 256
+
+/**
+ * Spins through some loop iterations, then echoes its input with every byte
+ * 	incremented until the input ends.
+ */
+static char echo_source[] = "tttttttthLtttttttthLtttttttthLtHmlHmlHml MhtTMl";
+
+/**
+ * Walks off the end of the tape, setting every cell on the way.
+ */
+static char overrun_source[] = "thLtl";
+
+static const int engines[] = {HTML_ENGINE_SWITCH, HTML_ENGINE_THREADED, HTML_ENGINE_JIT};
+static const int tapes[] = {HTML_TAPE_FIXED, HTML_TAPE_GROWABLE, HTML_TAPE_GUARDED, HTML_TAPE_SPARSE,
+                            HTML_TAPE_GUARDED | HTML_TAPE_CELLS_16};
+
+static const HtmlProgram *echo;
+static const HtmlProgram *overrun;
+
+/**
+ * The input and output of one execution, reached through the userdata of its context.
+ */
+typedef struct Job
+{
+    const char *input;
+    size_t input_position;
+    size_t input_length;
+    char output[MAX_OUTPUT];
+    size_t output_length;
+} Job;
+
+static long read_input(HtmlExecutionContext *context, char *buffer, size_t capacity)
+{
+    Job *job = (Job *)context->userdata;
+    size_t length = job->input_length - job->input_position;
+    if (length > capacity)
+        length = capacity;
+    memcpy(buffer, job->input + job->input_position, length);
+    job->input_position += length;
+    return (long)length;
+}
+
+static int write_output(HtmlExecutionContext *context, const char *buffer, size_t length)
+{
+    Job *job = (Job *)context->userdata;
+    if (job->output_length + length > MAX_OUTPUT)
+        return -1;
+    memcpy(job->output + job->output_length, buffer, length);
+    job->output_length += length;
+    return 0;
+}
+
+/**
+ * Executes the shared programs over and over in contexts of its own, with
+ * 	every engine and kind of tape, and checks what each execution returns.
+ */
+static void *serve(void *argument)
+{
+    long number = (long)argument;
+    char input[32];
+    int round;
+    size_t i;
+    sprintf(input, "request %ld", number);
+    for (round = 0; round < ROUNDS; round++)
+    {
+        Job job;
+        HtmlStatus status;
+        HtmlExecutionContext *context = html_context_tape(1024, tapes[(number + round) % 5]);
+        if (context == NULL)
+            return (void *)"failed to allocate a context";
+        memset(&job, 0, sizeof(Job));
+        job.input = input;
+        job.input_length = strlen(input);
+        context->userdata = &job;
+        context->engine = engines[round % 3];
+        context->eof_behavior = HTML_EOF_ZERO;
+        context->output_sink = &write_output;
+        html_set_input_source(context, &read_input);
+
+        status = html_execute_program(echo, context);
+        if (status.code != HTML_EXECUTION_DONE || job.output_length != job.input_length)
+            return (void *)"echo did not run to its end";
+        for (i = 0; i < job.input_length; i++)
+            if (job.output[i] != input[i] + 1)
+                return (void *)"echo output differs";
+
+        status = html_execute_program(overrun, context);
+        if (status.code != HTML_EXECUTION_OVERRUN)
+            return (void *)"overrun was not reported";
+        html_destroy_context(context);
+    }
+    return NULL;
+}
+
+/**
+ * Compiles the given source code, without keeping the instructions around.
+ */
+static HtmlProgram *compile(char *source)
+{
+    HtmlState *state = html_state();
+    HtmlProgram *program;
+    html_add(state, html_parse_string(source));
+    html_optimize(state->root);
+    program = html_compile(state->root);
+    html_destroy_state(state);
+    return program;
+}
+
+/**
+ * Executes two programs from several threads at once, each thread with its
+ * 	own contexts, input and output.
+ */
+int main()
+{
+    pthread_t threads[THREADS];
+    HtmlProgram *programs[2];
+    void *result;
+    int failed = 0;
+    long i;
+
+    programs[0] = compile(echo_source);
+    programs[1] = compile(overrun_source);
+    if (programs[0] == NULL || programs[1] == NULL)
+        return EXIT_FAILURE;
+    echo = programs[0];
+    overrun = programs[1];
+    for (i = 0; i < THREADS; i++)
+        if (pthread_create(threads + i, NULL, &serve, (void *)i) != 0)
+            return EXIT_FAILURE;
+    for (i = 0; i < THREADS; i++)
+    {
+        pthread_join(threads[i], &result);
+        if (result != NULL)
+        {
+            fprintf(stderr, "thread %ld: %s\n", i, (const char *)result);
+            failed = 1;
+        }
+    }
+    html_destroy_program(programs[0]);
+    html_destroy_program(programs[1]);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}